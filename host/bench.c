@@ -0,0 +1,722 @@
+/*
+ * bench.c
+ *
+ * Benchmarks for the drawing primitives and the flush path on the host build.
+ *
+ * Primitive runs draw with the display held, so only drawing is timed, and
+ * report ns/op and pixels/s.  Workload runs draw and show complete frames the
+ * way an application would and report CPU time plus I2C bytes, transactions
+ * and wire time per frame from the mock bus.  Every workload frame is checked
+ * against the SSD1306 model.
+ *
+ * Usage: display_bench [scale]     (scale multiplies the iteration counts)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ssd1306_i2c.h"
+#include "widget.h"
+#include "font8x8_basic.h"
+#include "font8x8_prop.h"
+#include "icon16.h"             /* 16 x 16 framed circle, from assets/icon16.pbm */
+#include "splash.h"             /* 128 x 64 boot screen, from assets/splash.pbm ... */
+#include "splash_rle.h"         /* ... RLE packed */
+#include "splash_lz.h"          /* ... and LZ packed */
+#include "host_i2c.h"
+#include "ssd1306_emu.h"
+
+#define I2C_NUM     CONFIG_SSD1306_I2C_CHANNEL_NUMBER
+
+static ssd1306_emu_t emu;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Primitive benchmarks
+ */
+typedef struct {
+    const char  *name;
+    int         pixels;                 /* Pixels covered by one call */
+    void        (*draw)(display_t *display, int i);
+} bench_primitive_t;
+
+static void draw_text(display_t *display, int i)
+{
+    display->draw_text(display, (i * 8) % 48, (i * 8) % 56, "Hello, 42");
+}
+
+static void draw_text_unaligned(display_t *display, int i)
+{
+    display->draw_text(display, (i * 8) % 48, (i * 8) % 48 + 3, "Hello, 42");
+}
+
+static void draw_bitmap(display_t *display, int i, int y, bitmap_method_t method)
+{
+    display->draw_bitmap(display, &icon16, (i * 16) % 112, y, icon16.width, icon16.height, method);
+}
+
+static void bitmap_or_aligned(display_t *display, int i)    { draw_bitmap(display, i, 16, bitmap_method_OR); }
+static void bitmap_or_unaligned(display_t *display, int i)  { draw_bitmap(display, i, 19, bitmap_method_OR); }
+static void bitmap_xor_aligned(display_t *display, int i)   { draw_bitmap(display, i, 16, bitmap_method_XOR); }
+static void bitmap_xor_unaligned(display_t *display, int i) { draw_bitmap(display, i, 19, bitmap_method_XOR); }
+static void bitmap_nand_aligned(display_t *display, int i)  { draw_bitmap(display, i, 16, bitmap_method_NAND); }
+static void bitmap_nand_unaligned(display_t *display, int i){ draw_bitmap(display, i, 19, bitmap_method_NAND); }
+
+/* The whole screen, from raw and from compressed bits */
+static void splash_raw_aligned(display_t *display, int i)   { display->draw_bitmap(display, &splash, 0, 0, 128, 64, bitmap_method_OR); }
+static void splash_raw_unaligned(display_t *display, int i) { display->draw_bitmap(display, &splash, 0, 3, 128, 64, bitmap_method_OR); }
+static void splash_rle_aligned(display_t *display, int i)   { display->draw_bitmap(display, &splash_rle, 0, 0, 128, 64, bitmap_method_OR); }
+static void splash_rle_unaligned(display_t *display, int i) { display->draw_bitmap(display, &splash_rle, 0, 3, 128, 64, bitmap_method_OR); }
+static void splash_lz_aligned(display_t *display, int i)    { display->draw_bitmap(display, &splash_lz, 0, 0, 128, 64, bitmap_method_OR); }
+static void splash_lz_unaligned(display_t *display, int i)  { display->draw_bitmap(display, &splash_lz, 0, 3, 128, 64, bitmap_method_OR); }
+
+/* A wrapped three line status message: laid out every call, or once and redrawn */
+static const char status_message[] = "Sensor offline: check the wiring and restart the unit";
+
+static display_text_layout_t status_layout = DISPLAY_TEXT_LAYOUT_INIT(4, 8, 120, 24, display_align_center);
+
+static void layout_status(display_t *display, int i)
+{
+    display_layout_text(&status_layout, &font8x8_prop, status_message);
+    display->draw_layout(display, &status_layout);
+}
+
+static void layout_status_cached(display_t *display, int i)
+{
+    if (status_layout.font != &font8x8_prop) {
+        display_layout_text(&status_layout, &font8x8_prop, status_message);
+    }
+    display->draw_layout(display, &status_layout);
+}
+
+static void line_horizontal(display_t *display, int i)  { display->draw_line(display, 4, i % 64, 123, i % 64, i & 1); }
+static void line_vertical(display_t *display, int i)    { display->draw_line(display, i % 128, 2, i % 128, 61, i & 1); }
+static void line_diagonal(display_t *display, int i)    { display->draw_line(display, 0, i % 8, 119, 63 - i % 8, i & 1); }
+
+static void rectangle_fill(display_t *display, int i)   { display->draw_rectangle(display, i % 16, 5 + i % 7, 100, 40, draw_flag_fill); }
+static void rectangle_border(display_t *display, int i) { display->draw_rectangle(display, i % 16, 5 + i % 7, 100, 40, draw_flag_border); }
+static void rectangle_clear(display_t *display, int i)  { display->draw_rectangle(display, i % 16, 5 + i % 7, 100, 40, draw_flag_clear); }
+
+static void progress_bar(display_t *display, int i)
+{
+    display->draw_progress_bar(display, 4, 40, 120, 14, 100, i % 101, "50%");
+}
+
+static const bench_primitive_t primitives[] = {
+    { "draw_text (9 chars)",            9 * 64,     draw_text },
+    { "draw_text unaligned (9 chars)",  9 * 64,     draw_text_unaligned },
+    { "draw_bitmap OR aligned",         256,        bitmap_or_aligned },
+    { "draw_bitmap OR unaligned",       256,        bitmap_or_unaligned },
+    { "draw_bitmap XOR aligned",        256,        bitmap_xor_aligned },
+    { "draw_bitmap XOR unaligned",      256,        bitmap_xor_unaligned },
+    { "draw_bitmap NAND aligned",       256,        bitmap_nand_aligned },
+    { "draw_bitmap NAND unaligned",     256,        bitmap_nand_unaligned },
+    { "draw_bitmap splash raw",         8192,       splash_raw_aligned },
+    { "draw_bitmap splash raw unal.",   8192,       splash_raw_unaligned },
+    { "draw_bitmap splash RLE",         8192,       splash_rle_aligned },
+    { "draw_bitmap splash RLE unal.",   8192,       splash_rle_unaligned },
+    { "draw_bitmap splash LZ",          8192,       splash_lz_aligned },
+    { "draw_bitmap splash LZ unal.",    8192,       splash_lz_unaligned },
+    { "layout + draw_layout (3 lines)", 120 * 24,   layout_status },
+    { "draw_layout cached (3 lines)",   120 * 24,   layout_status_cached },
+    { "draw_line horizontal",           120,        line_horizontal },
+    { "draw_line vertical",             60,         line_vertical },
+    { "draw_line diagonal",             120,        line_diagonal },
+    { "draw_rectangle fill 100x40",     4000,       rectangle_fill },
+    { "draw_rectangle border 100x40",   276,        rectangle_border },
+    { "draw_rectangle clear 100x40",    4000,       rectangle_clear },
+    { "draw_progress_bar 120x14",       120 * 14,   progress_bar },
+};
+
+static void bench_primitives(display_t *display, int scale)
+{
+    printf("%-32s %12s %14s\n", "primitive", "ns/op", "Mpixels/s");
+
+    for (size_t index = 0; index < sizeof(primitives) / sizeof(primitives[0]); ++index) {
+        const bench_primitive_t *bench = &primitives[index];
+        int count = 20000 * scale;
+
+        display->clear(display);
+        display->hold(display);
+
+        uint64_t start = now_ns();
+
+        for (int i = 0; i < count; ++i) {
+            bench->draw(display, i);
+        }
+
+        uint64_t elapsed = now_ns() - start;
+
+        /* Flush outside the timed region */
+        display->show(display);
+        display->wait_flushed(display, portMAX_DELAY);
+
+        double ns = (double) elapsed / count;
+
+        printf("%-32s %12.1f %14.2f\n", bench->name, ns, bench->pixels / ns * 1e3);
+    }
+}
+
+/*
+ * Frame workloads
+ */
+typedef struct {
+    const char  *name;
+    void        (*frame)(display_t *display, int frame);
+    void        (*end)(display_t *display);     /* Optional cleanup after the run */
+} bench_workload_t;
+
+/* Four numeric fields, one or two of which change per frame */
+static void dashboard(display_t *display, int frame)
+{
+    static const char *labels[] = { "Temp", "Hum", "Pres", "Wind" };
+    char text[20];
+
+    if (frame == 0) {
+        display->clear(display);
+        display->draw_rectangle(display, 0, 0, 128, 64, draw_flag_border);
+    }
+
+    for (int field = 0; field < 4; ++field) {
+        if (frame == 0 || (frame + field) % 3 == 0) {
+            snprintf(text, sizeof(text), "%-4s %5d", labels[field], (frame * (field + 7)) % 10000);
+
+            display->draw_rectangle(display, 4, 4 + field * 14, 120, 10, draw_flag_clear);
+            display->draw_text(display, 8, 5 + field * 14, text);
+        }
+    }
+}
+
+/* The dashboard built as one draw list: a single lock and flush per frame */
+static void dashboard_list(display_t *display, int frame)
+{
+    static const char *labels[] = { "Temp", "Hum", "Pres", "Wind" };
+    static char text[4][20];
+    display_op_t ops[2 + 4 * 2];
+    int count = 0;
+
+    if (frame == 0) {
+        ops[count++] = (display_op_t) DISPLAY_OP_CLEAR();
+        ops[count++] = (display_op_t) DISPLAY_OP_RECTANGLE(0, 0, 128, 64, draw_flag_border);
+    }
+
+    for (int field = 0; field < 4; ++field) {
+        if (frame == 0 || (frame + field) % 3 == 0) {
+            snprintf(text[field], sizeof(text[field]), "%-4s %5d", labels[field], (frame * (field + 7)) % 10000);
+
+            ops[count++] = (display_op_t) DISPLAY_OP_RECTANGLE(4, 4 + field * 14, 120, 10, draw_flag_clear);
+            ops[count++] = (display_op_t) DISPLAY_OP_TEXT(8, 5 + field * 14, text[field]);
+        }
+    }
+
+    display->draw_list(display, ops, count);
+}
+
+/* The dashboard through text fields: only the digits that changed are redrawn */
+static void dashboard_fields(display_t *display, int frame)
+{
+    static const char *labels[] = { "Temp", "Hum", "Pres", "Wind" };
+    static display_text_field_t fields[4];
+
+    if (frame == 0) {
+        display->clear(display);
+        display->draw_rectangle(display, 0, 0, 128, 64, draw_flag_border);
+
+        for (int field = 0; field < 4; ++field) {
+            fields[field] = (display_text_field_t) DISPLAY_TEXT_FIELD_INIT(8, 5 + field * 14, 112);
+        }
+    }
+
+    for (int field = 0; field < 4; ++field) {
+        if (frame == 0 || (frame + field) % 3 == 0) {
+            display->draw_field(display, &fields[field], "%-4s %5d", labels[field], (frame * (field + 7)) % 10000);
+        }
+    }
+}
+
+#if CONFIG_DISPLAY_WIDGETS_ENABLED
+/* The dashboard as retained widgets: only the fields whose value changed are redrawn */
+static void dashboard_widgets(display_t *display, int frame)
+{
+    static const char *labels[] = { "Temp", "Hum", "Pres", "Wind" };
+    static widget_screen_t screen;
+    static widget_t frame_box, names[4], values[4];
+
+    if (frame == 0) {
+        display->clear(display);
+
+        widget_screen_init(&screen, display);
+        widget_box_init(&screen, &frame_box, 0, 0, 128, 64, draw_flag_border);
+
+        for (int field = 0; field < 4; ++field) {
+            widget_label_init(&screen, &names[field], 8, 5 + field * 14, 40, display_align_left, labels[field]);
+            widget_value_init(&screen, &values[field], 48, 5 + field * 14, 72, display_align_right, "%d", 0);
+        }
+    }
+
+    for (int field = 0; field < 4; ++field) {
+        if ((frame + field) % 3 == 0) {
+            widget_set_value(&values[field], (frame * (field + 7)) % 10000);
+        }
+    }
+
+    widget_render(&screen);
+}
+#endif
+
+/* Eight-line log, redrawn with a new line at the bottom every frame */
+static void scrolling_log(display_t *display, int frame)
+{
+    char text[20];
+
+    display->clear(display);
+
+    for (int line = 0; line < 8; ++line) {
+        snprintf(text, sizeof(text), "%05d event %d", frame + line, (frame + line) % 7);
+        display->draw_text(display, 0, line * 8, text);
+    }
+}
+
+/* The same log in the variable pitch font */
+static void scrolling_log_prop(display_t *display, int frame)
+{
+    if (frame == 0) {
+        display->set_font(display, &font8x8_prop);
+    }
+
+    scrolling_log(display, frame);
+}
+
+static void scrolling_log_prop_end(display_t *display)
+{
+    display->set_font(display, &font8x8_basic);
+}
+
+/* Progress bar with percentage moving one step per frame */
+static void progress_animation(display_t *display, int frame)
+{
+    char text[8];
+
+    if (frame == 0) {
+        display->clear(display);
+        display->draw_text(display, 16, 8, "Updating...");
+    }
+
+    snprintf(text, sizeof(text), "%d%%", frame % 101);
+
+    display->draw_progress_bar(display, 4, 32, 120, 16, 100, frame % 101, text);
+}
+
+/* The same animation through a progress bar handle: only the moved columns are painted */
+static void progress_incremental(display_t *display, int frame)
+{
+    static display_progress_bar_t bar;
+    char text[8];
+
+    if (frame == 0) {
+        display->clear(display);
+        display->draw_text(display, 16, 8, "Updating...");
+
+        bar = (display_progress_bar_t) DISPLAY_PROGRESS_BAR_INIT(4, 32, 120, 16, 100);
+    }
+
+    snprintf(text, sizeof(text), "%d%%", frame % 101);
+
+    display->update_progress_bar(display, &bar, frame % 101, text);
+}
+
+/* Whole screen redrawn from scratch */
+static void full_redraw(display_t *display, int frame)
+{
+    display->clear(display);
+
+    for (int line = 0; line < 8; ++line) {
+        display->draw_text(display, 0, line * 8, "ABCDEFGHIJKLMNOP" + (frame + line) % 8);
+    }
+}
+
+/* Ticker text on one page moving a column per frame, redrawn in software */
+static void marquee(display_t *display, int frame)
+{
+    static const char text[] = "Breaking: marquee ticker  ";
+    int length = sizeof(text) - 1;
+    int x = -(frame % (length * 8));
+
+    if (frame == 0) {
+        display->clear(display);
+    }
+
+    display->draw_rectangle(display, 0, 24, 128, 8, draw_flag_clear);
+
+    /* Glyph by glyph so the line is clipped rather than wrapped */
+    for (int index = 0; x < display->width; ++index, x += 8) {
+        bitmap_t bitmap;
+
+        if (x > -8 && char_to_bitmap(&bitmap, display->font, text[index % length])) {
+            display->draw_bitmap(display, &bitmap, x, 24, bitmap.width, bitmap.height, bitmap_method_OR);
+        }
+    }
+}
+
+#if CONFIG_DISPLAY_CONSOLE_ENABLED
+/* The scrolling log as a console: one new line per frame */
+static void console_log(display_t *display, int frame)
+{
+    char text[20];
+
+    if (frame == 0) {
+        display->console_enable(display, true);
+    }
+
+    snprintf(text, sizeof(text), "%05d event %d", frame + 7, (frame + 7) % 7);
+    display->console_write(display, text);
+}
+
+static void console_end(display_t *display)
+{
+    display->console_enable(display, false);
+}
+#endif
+
+static const bench_workload_t workloads[] = {
+    { "dashboard refresh",      dashboard },
+    { "dashboard (draw list)",  dashboard_list },
+    { "dashboard (fields)",     dashboard_fields },
+#if CONFIG_DISPLAY_WIDGETS_ENABLED
+    { "dashboard (widgets)",    dashboard_widgets },
+#endif
+    { "scrolling log",          scrolling_log },
+    { "scrolling log (prop.)",  scrolling_log_prop, scrolling_log_prop_end },
+    { "progress animation",     progress_animation },
+    { "progress (incremental)", progress_incremental },
+    { "full redraw",            full_redraw },
+    { "marquee (software)",     marquee },
+#if CONFIG_DISPLAY_CONSOLE_ENABLED
+    { "console log",            console_log,    console_end },
+#endif
+};
+
+static void bench_workloads(display_t *display, int scale)
+{
+    printf("\n%-24s %12s %12s %12s %12s %12s %8s\n", "workload", "us/frame", "bytes/frame", "trans/frame", "bus ms/fr", "allocs/fr", "panel");
+
+    for (size_t index = 0; index < sizeof(workloads) / sizeof(workloads[0]); ++index) {
+        const bench_workload_t *bench = &workloads[index];
+        int frames = 200 * scale;
+        bool matches = true;
+        uint64_t elapsed = 0;
+
+        host_i2c_stats_t bus;
+
+        host_i2c_reset_stats(I2C_NUM);
+
+        for (int frame = 0; frame < frames; ++frame) {
+            uint64_t start = now_ns();
+
+            display->hold(display);
+            bench->frame(display, frame);
+            display->show(display);
+            display->wait_flushed(display, portMAX_DELAY);
+
+            elapsed += now_ns() - start;
+
+            if (!ssd1306_emu_matches(&emu, display->frame_buf, display->width, display->height)) {
+                matches = false;
+            }
+        }
+
+        host_i2c_get_stats(I2C_NUM, &bus);
+
+        if (bench->end != NULL) {
+            bench->end(display);
+            display->wait_flushed(display, portMAX_DELAY);
+        }
+
+        printf("%-24s %12.1f %12.1f %12.2f %12.2f %12.2f %8s\n", bench->name,
+               elapsed / 1e3 / frames,
+               (double) bus.bytes / frames,
+               (double) bus.transactions / frames,
+               bus.bus_time_ns / 1e6 / frames,
+               (double) bus.link_allocs / frames,
+               matches ? "ok" : "DIFFERS");
+    }
+}
+
+#if CONFIG_DISPLAY_ASYNC_FLUSH
+/* The workloads on a display flushed by its background task, drawing on while earlier frames go out */
+static void bench_async_flush(int scale)
+{
+    display_t *display = ssd1306_i2c_create(DISPLAY_FLAGS_ASYNC);
+
+    printf("\n%-24s %12s %12s %12s %8s\n", "async workload", "us/frame", "bytes/frame", "trans/frame", "panel");
+
+    for (size_t index = 0; index < sizeof(workloads) / sizeof(workloads[0]); ++index) {
+        const bench_workload_t *bench = &workloads[index];
+        int frames = 200 * scale;
+        host_i2c_stats_t bus;
+
+        host_i2c_reset_stats(I2C_NUM);
+
+        uint64_t start = now_ns();
+
+        for (int frame = 0; frame < frames; ++frame) {
+            display->hold(display);
+            bench->frame(display, frame);
+            display->show(display);
+        }
+
+        uint64_t elapsed = now_ns() - start;
+
+        display->wait_flushed(display, portMAX_DELAY);
+
+        host_i2c_get_stats(I2C_NUM, &bus);
+
+        bool matches = ssd1306_emu_matches(&emu, display->frame_buf, display->width, display->height);
+
+        if (bench->end != NULL) {
+            bench->end(display);
+            display->wait_flushed(display, portMAX_DELAY);
+
+            matches = matches && ssd1306_emu_matches(&emu, display->frame_buf, display->width, display->height);
+        }
+
+        printf("%-24s %12.1f %12.1f %12.2f %8s\n", bench->name,
+               elapsed / 1e3 / frames,
+               (double) bus.bytes / frames,
+               (double) bus.transactions / frames,
+               matches ? "ok" : "DIFFERS");
+    }
+
+    display->close(display);
+}
+#endif
+
+#if CONFIG_DISPLAY_SCROLL_ENABLED
+/* The same ticker left to the controller: set up once, then no traffic per frame */
+static void bench_hardware_scroll(display_t *display, int scale)
+{
+    int frames = 200 * scale;
+    host_i2c_stats_t bus;
+
+    marquee(display, 0);
+    display->show(display);
+    display->wait_flushed(display, portMAX_DELAY);
+
+    host_i2c_reset_stats(I2C_NUM);
+
+    uint64_t start = now_ns();
+
+    display->start_scroll(display, display_scroll_left, 3, 3, 2, 0);
+    ssd1306_emu_tick(&emu, frames * 2);
+
+    uint64_t elapsed = now_ns() - start;
+
+    host_i2c_get_stats(I2C_NUM, &bus);
+
+    /* Drawing during the scroll stays in the frame buffer until stop_scroll */
+    display->draw_text(display, 0, 0, "scrolling");
+    display->wait_flushed(display, portMAX_DELAY);
+
+    host_i2c_stats_t during;
+
+    host_i2c_get_stats(I2C_NUM, &during);
+
+    display->stop_scroll(display);
+    display->wait_flushed(display, portMAX_DELAY);
+
+    bool matches = during.bytes == bus.bytes && ssd1306_emu_matches(&emu, display->frame_buf, display->width, display->height);
+
+    printf("%-24s %12.1f %12.1f %12.2f %12.2f %12.2f %8s\n", "marquee (hardware)",
+           elapsed / 1e3 / frames,
+           (double) bus.bytes / frames,
+           (double) bus.transactions / frames,
+           bus.bus_time_ns / 1e6 / frames,
+           (double) bus.link_allocs / frames,
+           matches ? "ok" : "DIFFERS");
+}
+#endif
+
+#if CONFIG_DISPLAY_RENDER_QUEUE
+/*
+ * Render queue: producer tasks submit status lines concurrently, never taking
+ * the display lock, while the render task draws and flushes them in batches.
+ */
+#define BENCH_PRODUCERS     4
+
+typedef struct {
+    display_t           *display;
+    int                 row;
+    int                 commands;
+    uint64_t            submit_ns;      /* Time spent inside submit() */
+    EventGroupHandle_t  done;
+} bench_producer_t;
+
+static void bench_producer(void *param)
+{
+    bench_producer_t *producer = (bench_producer_t *) param;
+    char text[20];
+
+    for (int i = 0; i < producer->commands; ++i) {
+        snprintf(text, sizeof(text), "task %d: %6d", producer->row, i);
+
+        display_op_t op = DISPLAY_OP_TEXT(0, producer->row * 8, text);
+
+        /* Text draws with XOR, so each update erases the line first */
+        display_op_t erase = DISPLAY_OP_RECTANGLE(0, producer->row * 8, 128, 8, draw_flag_clear);
+
+        uint64_t start = now_ns();
+
+        producer->display->submit(producer->display, &erase);
+        producer->display->submit(producer->display, &op);
+
+        producer->submit_ns += now_ns() - start;
+
+        if (i % 4 == 3) {
+            vTaskDelay(1);
+        }
+    }
+
+    xEventGroupSetBits(producer->done, 1 << producer->row);
+
+    vTaskDelete(NULL);
+}
+
+static void bench_render_queue(display_t *display, int scale)
+{
+    bench_producer_t producers[BENCH_PRODUCERS];
+    EventGroupHandle_t done = xEventGroupCreate();
+    display_render_stats_t stats;
+    host_i2c_stats_t bus;
+    uint64_t submit_ns = 0;
+    int commands = 0;
+
+    display->clear(display);
+    display->show(display);
+    display->wait_flushed(display, portMAX_DELAY);
+
+    host_i2c_reset_stats(I2C_NUM);
+
+    uint64_t start = now_ns();
+
+    for (int index = 0; index < BENCH_PRODUCERS; ++index) {
+        producers[index] = (bench_producer_t) {
+            .display  = display,
+            .row      = index,
+            .commands = 500 * scale,
+            .done     = done,
+        };
+
+        xTaskCreate(bench_producer, "producer", 2048, &producers[index], 5, NULL);
+    }
+
+    xEventGroupWaitBits(done, (1 << BENCH_PRODUCERS) - 1, pdFALSE, pdTRUE, portMAX_DELAY);
+    display->wait_rendered(display, portMAX_DELAY);
+
+    uint64_t elapsed = now_ns() - start;
+
+    for (int index = 0; index < BENCH_PRODUCERS; ++index) {
+        submit_ns += producers[index].submit_ns;
+        commands += producers[index].commands * 2;
+    }
+
+    display->get_render_stats(display, &stats);
+    host_i2c_get_stats(I2C_NUM, &bus);
+
+    printf("\nrender queue: %d producers, %d commands in %.1f ms, %.1f ns/submit, %u bytes on the bus\n",
+           BENCH_PRODUCERS, commands, elapsed / 1e6, (double) submit_ns / commands, (unsigned) bus.bytes);
+    printf("  submitted %u  dropped %u  rendered %u  batches %u  depth %u  max depth %u\n",
+           (unsigned) stats.submitted, (unsigned) stats.dropped, (unsigned) stats.rendered,
+           (unsigned) stats.batches, (unsigned) stats.depth, (unsigned) stats.max_depth);
+    printf("  latency avg %u us  max %u us  panel %s\n",
+           (unsigned) stats.latency_avg_us, (unsigned) stats.latency_max_us,
+           ssd1306_emu_matches(&emu, display->frame_buf, display->width, display->height) ? "ok" : "DIFFERS");
+
+    vEventGroupDelete(done);
+
+    /*
+     * Queued text longer than the cell, with a two byte character split by the
+     * cut: the renderer must drop the partial character rather than draw a
+     * replacement glyph.  Drawing the expected text again erases it (XOR).
+     */
+    char text[CONFIG_DISPLAY_RENDER_TEXT_LENGTH + 3];
+    size_t length = 0;
+
+    if ((CONFIG_DISPLAY_RENDER_TEXT_LENGTH - 1) % 2 == 0) {
+        text[length++] = '-';
+    }
+    while (length < CONFIG_DISPLAY_RENDER_TEXT_LENGTH) {
+        text[length++] = '\xc2';        /* U+00B0 DEGREE SIGN */
+        text[length++] = '\xb0';
+    }
+    text[length] = '\0';
+
+    display_op_t op = DISPLAY_OP_TEXT(0, 0, text);
+
+    display->clear(display);
+    display->submit(display, &op);
+    display->wait_rendered(display, portMAX_DELAY);
+
+    text[CONFIG_DISPLAY_RENDER_TEXT_LENGTH - 2] = '\0';
+
+    display->draw_text(display, 0, 0, text);
+    display->wait_flushed(display, portMAX_DELAY);
+
+    bool blank = true;
+
+    for (size_t index = 0; index < DISPLAY_FRAME_LEN(display->width, display->height); ++index) {
+        blank = blank && display->frame_buf[index] == 0;
+    }
+
+    printf("  queued text cut in a character: %s\n",
+           blank && ssd1306_emu_matches(&emu, display->frame_buf, display->width, display->height) ? "ok" : "DIFFERS");
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    int scale = argc > 1 ? atoi(argv[1]) : 1;
+
+    if (scale < 1) {
+        scale = 1;
+    }
+
+    ssd1306_emu_init(&emu, CONFIG_SSD1306_I2C_ADDR, CONFIG_SSD1306_I2C_WIDTH, CONFIG_SSD1306_I2C_HEIGHT);
+    ssd1306_emu_attach(&emu, I2C_NUM);
+
+#if CONFIG_DISPLAY_RENDER_QUEUE
+    display_t *display = ssd1306_i2c_create(DISPLAY_FLAGS_DEFAULT | DISPLAY_FLAGS_RENDER);
+#else
+    display_t *display = ssd1306_i2c_create(DISPLAY_FLAGS_DEFAULT);
+#endif
+
+    printf("display_bench: %dx%d, %d kHz I2C\n\n", display->width, display->height, CONFIG_SSD1306_I2C_CLK_SPEED / 1000);
+
+    bench_primitives(display, scale);
+#if CONFIG_DISPLAY_GLYPH_CACHE_STATS
+    printf("\nglyph cache: %u hits, %u misses\n", (unsigned) display->stats.glyph_hits, (unsigned) display->stats.glyph_misses);
+#endif
+    bench_workloads(display, scale);
+#if CONFIG_DISPLAY_SCROLL_ENABLED
+    bench_hardware_scroll(display, scale);
+#endif
+#if CONFIG_DISPLAY_RENDER_QUEUE
+    bench_render_queue(display, scale);
+#endif
+
+    display->close(display);
+
+#if CONFIG_DISPLAY_ASYNC_FLUSH
+    bench_async_flush(scale);
+#endif
+
+    return emu.stats.errors != 0;
+}
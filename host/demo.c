@@ -0,0 +1,70 @@
+/*
+ * demo.c
+ *
+ * Draws a few frames on the host build, reports what went over the mock bus
+ * and checks the emulated panel against the frame buffer.  With an argument,
+ * the final panel image is written there as a PBM.
+ */
+#include <stdio.h>
+
+#include "ssd1306_i2c.h"
+#include "host_i2c.h"
+#include "ssd1306_emu.h"
+#include "font8x8_basic.h"
+#include "digits5x7.h"         /* Generated from assets/digits5x7.bdf */
+
+int main(int argc, char **argv)
+{
+    static ssd1306_emu_t emu;
+    host_i2c_stats_t bus;
+
+    ssd1306_emu_init(&emu, CONFIG_SSD1306_I2C_ADDR, CONFIG_SSD1306_I2C_WIDTH, CONFIG_SSD1306_I2C_HEIGHT);
+    ssd1306_emu_attach(&emu, CONFIG_SSD1306_I2C_CHANNEL_NUMBER);
+
+    display_t *display = ssd1306_i2c_create(DISPLAY_FLAGS_DEFAULT);
+
+    display->show(display);
+
+    for (int frame = 0; frame < 10; ++frame) {
+        char text[16];
+
+        snprintf(text, sizeof(text), "Frame %d", frame);
+
+        host_i2c_reset_stats(CONFIG_SSD1306_I2C_CHANNEL_NUMBER);
+
+        display->hold(display);
+        display->draw_rectangle(display, 0, 8, 128, 32, draw_flag_clear);
+        display->set_font(display, &digits5x7);
+        display->draw_textf(display, 0, 10, "%d.%d\u00B0C", 20 + frame / 4, frame * 3 % 10);
+        display->set_font(display, &font8x8_basic);
+        display->draw_text(display, 0, 28, text);
+        display->draw_progress_bar(display, 0, 48, 128, 12, 9, frame, NULL);
+        display->show(display);
+
+        display->wait_flushed(display, portMAX_DELAY);
+
+        host_i2c_get_stats(CONFIG_SSD1306_I2C_CHANNEL_NUMBER, &bus);
+
+        printf("frame %d: %u transactions, %u bytes, %.2f ms on the bus, panel %s\n",
+               frame, bus.transactions, bus.bytes, bus.bus_time_ns / 1e6,
+               ssd1306_emu_matches(&emu, display->frame_buf, display->width, display->height) ? "matches" : "DIFFERS");
+    }
+
+    printf("total: %u frames, %u bytes sent, %u bytes saved\n",
+           display->stats.frames, display->stats.bytes_sent, display->stats.bytes_saved);
+
+    if (argc > 1) {
+        FILE *fp = fopen(argv[1], "w");
+
+        if (fp == NULL || ssd1306_emu_write_pbm(&emu, fp) != 0) {
+            perror(argv[1]);
+            return 1;
+        }
+
+        fclose(fp);
+    }
+
+    display->close(display);
+
+    return emu.stats.errors != 0;
+}
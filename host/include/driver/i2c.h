@@ -0,0 +1,71 @@
+/*
+ * i2c.h
+ *
+ * Host shim: the legacy ESP-IDF I2C master command-link API.  Command links
+ * record operations in memory; i2c_master_cmd_begin replays them onto the
+ * mock bus (see host_i2c.h).  Like the real driver, i2c_master_write keeps a
+ * pointer to the caller's data until the link is executed.
+ */
+#ifndef __host_i2c_h_included
+#define __host_i2c_h_included
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "driver/gpio.h"
+
+#define I2C_NUM_0           0
+#define I2C_NUM_1           1
+#define I2C_NUM_MAX         2
+
+typedef int i2c_port_t;
+typedef void *i2c_cmd_handle_t;
+
+typedef enum {
+    I2C_MODE_SLAVE = 0,
+    I2C_MODE_MASTER,
+} i2c_mode_t;
+
+typedef enum {
+    I2C_MASTER_WRITE = 0,
+    I2C_MASTER_READ,
+} i2c_rw_t;
+
+typedef struct {
+    i2c_mode_t      mode;
+    int             sda_io_num;
+    int             scl_io_num;
+    bool            sda_pullup_en;
+    bool            scl_pullup_en;
+    union {
+        struct {
+            uint32_t clk_speed;
+        } master;
+    };
+    uint32_t        clk_flags;
+} i2c_config_t;
+
+/* Size of one queued operation; mirrors I2C_INTERNAL_STRUCT_SIZE in ESP-IDF */
+#define I2C_INTERNAL_STRUCT_SIZE        (sizeof(void *) * 4)
+#define I2C_LINK_RECOMMENDED_SIZE(TRANSACTIONS) \
+            (2 * I2C_INTERNAL_STRUCT_SIZE + I2C_INTERNAL_STRUCT_SIZE * (5 * (TRANSACTIONS)))
+
+esp_err_t        i2c_param_config(i2c_port_t i2c_num, const i2c_config_t *config);
+esp_err_t        i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode, size_t slv_rx_buf_len, size_t slv_tx_buf_len, int intr_alloc_flags);
+esp_err_t        i2c_driver_delete(i2c_port_t i2c_num);
+
+i2c_cmd_handle_t i2c_cmd_link_create(void);
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t *buffer, uint32_t size);
+void             i2c_cmd_link_delete(i2c_cmd_handle_t cmd);
+void             i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd);
+
+esp_err_t        i2c_master_start(i2c_cmd_handle_t cmd);
+esp_err_t        i2c_master_write_byte(i2c_cmd_handle_t cmd, uint8_t data, bool ack_en);
+esp_err_t        i2c_master_write(i2c_cmd_handle_t cmd, const uint8_t *data, size_t data_len, bool ack_en);
+esp_err_t        i2c_master_stop(i2c_cmd_handle_t cmd);
+esp_err_t        i2c_master_cmd_begin(i2c_port_t i2c_num, i2c_cmd_handle_t cmd, TickType_t ticks_to_wait);
+
+#endif /* __host_i2c_h_included */
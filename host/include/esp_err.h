@@ -0,0 +1,31 @@
+/*
+ * esp_err.h
+ *
+ * Host shim: error codes and ESP_ERROR_CHECK.
+ */
+#ifndef __host_esp_err_h_included
+#define __host_esp_err_h_included
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK                 0
+#define ESP_FAIL              -1
+#define ESP_ERR_NO_MEM         0x101
+#define ESP_ERR_INVALID_ARG    0x102
+#define ESP_ERR_INVALID_STATE  0x103
+#define ESP_ERR_TIMEOUT        0x107
+
+#define ESP_ERROR_CHECK(x) do {                                                  \
+        esp_err_t __err_rc = (x);                                                \
+        if (__err_rc != ESP_OK) {                                                \
+            fprintf(stderr, "ESP_ERROR_CHECK failed: 0x%x at %s:%d (%s)\n",      \
+                    __err_rc, __FILE__, __LINE__, #x);                           \
+            abort();                                                             \
+        }                                                                        \
+    } while (0)
+
+#endif /* __host_esp_err_h_included */
@@ -0,0 +1,29 @@
+/*
+ * esp_log.h
+ *
+ * Host shim: log macros routed to stderr, filtered by a runtime level.
+ */
+#ifndef __host_esp_log_h_included
+#define __host_esp_log_h_included
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+/* Messages above this level are dropped (default ESP_LOG_WARN) */
+extern esp_log_level_t host_log_level;
+
+void host_log_write(esp_log_level_t level, const char *tag, const char *format, ...);
+
+#define ESP_LOGE(tag, format, ...)  host_log_write(ESP_LOG_ERROR,   tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)  host_log_write(ESP_LOG_WARN,    tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)  host_log_write(ESP_LOG_INFO,    tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)  host_log_write(ESP_LOG_DEBUG,   tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)  host_log_write(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
+
+#endif /* __host_esp_log_h_included */
@@ -0,0 +1,14 @@
+/*
+ * esp_timer.h
+ *
+ * Host shim: microsecond clock.
+ */
+#ifndef __host_esp_timer_h_included
+#define __host_esp_timer_h_included
+
+#include <stdint.h>
+
+/* Microseconds since the process started (monotonic) */
+int64_t esp_timer_get_time(void);
+
+#endif /* __host_esp_timer_h_included */
@@ -0,0 +1,34 @@
+/*
+ * FreeRTOS.h
+ *
+ * Host shim: basic FreeRTOS types and tick conversion.  Ticks are virtual;
+ * vTaskDelay advances the tick count rather than sleeping.
+ */
+#ifndef __host_freertos_h_included
+#define __host_freertos_h_included
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "sdkconfig.h"
+
+typedef int                 BaseType_t;
+typedef unsigned int        UBaseType_t;
+typedef uint32_t            TickType_t;
+typedef uint32_t            StackType_t;
+
+#define pdFALSE             ((BaseType_t) 0)
+#define pdTRUE              ((BaseType_t) 1)
+#define pdPASS              pdTRUE
+#define pdFAIL              pdFALSE
+
+#define portMAX_DELAY       ((TickType_t) 0xFFFFFFFFUL)
+#define portTICK_PERIOD_MS  ((TickType_t) 1000 / CONFIG_FREERTOS_HZ)
+#define pdMS_TO_TICKS(ms)   ((TickType_t) (((TickType_t) (ms) * (TickType_t) CONFIG_FREERTOS_HZ) / (TickType_t) 1000))
+
+#define configMAX_PRIORITIES 25
+#define tskIDLE_PRIORITY    0
+
+#endif /* __host_freertos_h_included */
@@ -0,0 +1,26 @@
+/*
+ * event_groups.h
+ *
+ * Host shim: event groups on a mutex and condition variable.
+ */
+#ifndef __host_event_groups_h_included
+#define __host_event_groups_h_included
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_event_group *EventGroupHandle_t;
+typedef uint32_t EventBits_t;
+
+typedef struct {
+    void        *storage[24];
+} StaticEventGroup_t;
+
+EventGroupHandle_t xEventGroupCreate(void);
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *buffer);
+void               vEventGroupDelete(EventGroupHandle_t group);
+EventBits_t        xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t        xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t        xEventGroupGetBits(EventGroupHandle_t group);
+EventBits_t        xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit, BaseType_t wait_for_all, TickType_t ticks_to_wait);
+
+#endif /* __host_event_groups_h_included */
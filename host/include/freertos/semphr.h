@@ -0,0 +1,31 @@
+/*
+ * semphr.h
+ *
+ * Host shim: mutexes and semaphores on pthreads.
+ */
+#ifndef __host_semphr_h_included
+#define __host_semphr_h_included
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_semaphore *SemaphoreHandle_t;
+
+/* Storage for the *Static constructors */
+typedef struct {
+    void        *storage[24];
+} StaticSemaphore_t;
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void);
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic(StaticSemaphore_t *buffer);
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buffer);
+
+BaseType_t        xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks_to_wait);
+BaseType_t        xSemaphoreGiveRecursive(SemaphoreHandle_t sem);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t sem);
+void              vSemaphoreDelete(SemaphoreHandle_t sem);
+
+#endif /* __host_semphr_h_included */
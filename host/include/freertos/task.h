@@ -0,0 +1,44 @@
+/*
+ * task.h
+ *
+ * Host shim: tasks run as pthreads; direct-to-task notifications are
+ * implemented with a condition variable per task.
+ */
+#ifndef __host_task_h_included
+#define __host_task_h_included
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+typedef enum {
+    eRunning = 0,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid,
+} eTaskState;
+
+/* Storage for xTaskCreateStatic; the host keeps the real task state here */
+typedef struct {
+    void        *storage[32];
+} StaticTask_t;
+
+BaseType_t   xTaskCreate(TaskFunction_t code, const char *name, uint32_t stack_depth, void *param, UBaseType_t priority, TaskHandle_t *handle);
+TaskHandle_t xTaskCreateStatic(TaskFunction_t code, const char *name, uint32_t stack_depth, void *param, UBaseType_t priority, StackType_t *stack, StaticTask_t *task);
+void         vTaskDelete(TaskHandle_t task);
+void         vTaskSuspend(TaskHandle_t task);
+eTaskState   eTaskGetState(TaskHandle_t task);
+void         vTaskDelay(TickType_t ticks);
+TickType_t   xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+BaseType_t   xTaskNotifyGive(TaskHandle_t task);
+uint32_t     ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait);
+
+#define taskYIELD()   host_task_yield()
+void         host_task_yield(void);
+
+#endif /* __host_task_h_included */
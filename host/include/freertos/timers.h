@@ -0,0 +1,12 @@
+/*
+ * timers.h
+ *
+ * Host shim: only pulls in the task API, which is all the component uses.
+ */
+#ifndef __host_timers_h_included
+#define __host_timers_h_included
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#endif /* __host_timers_h_included */
@@ -0,0 +1,29 @@
+/*
+ * host_i2c.h
+ *
+ * Mock I2C bus for the host build.  Every START (or repeated START) to STOP
+ * segment executed by i2c_master_cmd_begin is one transaction; its bytes,
+ * address byte first, are handed to the device attached to the port.
+ */
+#ifndef __host_i2c_h_included_mock
+#define __host_i2c_h_included_mock
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct {
+    uint32_t    cmd_begins;     /* i2c_master_cmd_begin calls */
+    uint32_t    transactions;   /* START..STOP segments */
+    uint32_t    bytes;          /* Bytes clocked, address bytes included */
+    uint64_t    bus_time_ns;    /* Wire time: 9 clocks per byte plus START/STOP */
+    uint32_t    link_allocs;    /* Heap allocations made by dynamic command links */
+} host_i2c_stats_t;
+
+/* Receives one transaction; data[0] is the address byte */
+typedef void (*host_i2c_device_t)(void *ctx, const uint8_t *data, size_t len);
+
+void host_i2c_attach(int i2c_num, host_i2c_device_t device, void *ctx);
+void host_i2c_get_stats(int i2c_num, host_i2c_stats_t *stats);
+void host_i2c_reset_stats(int i2c_num);
+
+#endif /* __host_i2c_h_included_mock */
@@ -0,0 +1,76 @@
+/*
+ * sdkconfig.h
+ *
+ * Host build configuration.  Mirrors the Kconfig defaults so the component
+ * compiles the same feature set off-target.
+ */
+#ifndef __host_sdkconfig_h_included
+#define __host_sdkconfig_h_included
+
+#define CONFIG_SSD1306_I2C_ENABLED            1
+#define CONFIG_SSD1306_I2C_WIDTH              128
+#define CONFIG_SSD1306_I2C_HEIGHT             64
+#define CONFIG_SSD1306_I2C_CHANNEL_NUMBER     0
+#define CONFIG_SSD1306_I2C_SCL_GPIO           15
+#define CONFIG_SSD1306_I2C_SDA_GPIO           4
+#define CONFIG_SSD1306_I2C_RESET_GPIO         16
+#define CONFIG_SSD1306_I2C_CLK_SPEED          100000
+#define CONFIG_SSD1306_I2C_ADDR               0x3C
+#ifndef CONFIG_SSD1306_I2C_STATIC_LINKS
+#define CONFIG_SSD1306_I2C_STATIC_LINKS       1
+#endif
+
+/*
+ * Options that default to off in Kconfig are left undefined here; the host
+ * CMakeLists turns them on with -D when the matching option is set.
+ */
+#if CONFIG_DISPLAY_ASYNC_FLUSH
+#ifndef CONFIG_DISPLAY_FLUSH_TASK_PRIORITY
+#define CONFIG_DISPLAY_FLUSH_TASK_PRIORITY    5
+#endif
+#ifndef CONFIG_DISPLAY_FLUSH_TASK_STACK
+#define CONFIG_DISPLAY_FLUSH_TASK_STACK       2048
+#endif
+#endif
+#if CONFIG_DISPLAY_RENDER_QUEUE
+#ifndef CONFIG_DISPLAY_RENDER_QUEUE_LENGTH
+#define CONFIG_DISPLAY_RENDER_QUEUE_LENGTH    32
+#endif
+#ifndef CONFIG_DISPLAY_RENDER_TEXT_LENGTH
+#define CONFIG_DISPLAY_RENDER_TEXT_LENGTH     24
+#endif
+#ifndef CONFIG_DISPLAY_RENDER_TASK_PRIORITY
+#define CONFIG_DISPLAY_RENDER_TASK_PRIORITY   5
+#endif
+#ifndef CONFIG_DISPLAY_RENDER_TASK_STACK
+#define CONFIG_DISPLAY_RENDER_TASK_STACK      2048
+#endif
+#endif
+#if CONFIG_DISPLAY_GLYPH_CACHE
+#ifndef CONFIG_DISPLAY_GLYPH_CACHE_ENTRIES
+#define CONFIG_DISPLAY_GLYPH_CACHE_ENTRIES    64
+#endif
+#ifndef CONFIG_DISPLAY_GLYPH_CACHE_WIDTH
+#define CONFIG_DISPLAY_GLYPH_CACHE_WIDTH      8
+#endif
+#endif
+#if CONFIG_DISPLAY_TRACE
+#ifndef CONFIG_DISPLAY_TRACE_ENTRIES
+#define CONFIG_DISPLAY_TRACE_ENTRIES          128
+#endif
+#endif
+
+#define CONFIG_DISPLAY_EXTRA_FEATURES         1
+#define CONFIG_DISPLAY_RECTANGLE_ENABLED      1
+#define CONFIG_DISPLAY_LINE_ENABLED           1
+#define CONFIG_DISPLAY_PIXEL_ENABLED          1
+#define CONFIG_DISPLAY_PROGRESS_BAR_ENABLED   1
+#define CONFIG_DISPLAY_SCROLL_ENABLED         1
+#define CONFIG_DISPLAY_CONSOLE_ENABLED        1
+#define CONFIG_DISPLAY_WIDGETS_ENABLED        1
+#define CONFIG_DISPLAY_WIDGET_TEXT_LENGTH     24
+
+#define CONFIG_FREERTOS_HZ                    100
+#define CONFIG_FREERTOS_SUPPORT_STATIC_ALLOCATION 1
+
+#endif /* __host_sdkconfig_h_included */
@@ -0,0 +1,100 @@
+/*
+ * ssd1306_emu.h
+ *
+ * Software model of an SSD1306 controller for the host build.  Attached to a
+ * mock I2C port it parses the control/command/data stream the driver sends
+ * and maintains the 128 x 64 GDDRAM, so the result of any update strategy can
+ * be compared byte for byte with a full refresh and dumped as an image.
+ *
+ * The panel image assumes the usual module wiring, where segment remap (A1h)
+ * and COM remap (C8h) show GDDRAM upright.
+ */
+#ifndef __ssd1306_emu_h_included
+#define __ssd1306_emu_h_included
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SSD1306_EMU_COLUMNS     128
+#define SSD1306_EMU_PAGES       8
+#define SSD1306_EMU_ROWS        (SSD1306_EMU_PAGES * 8)
+
+typedef struct {
+    uint32_t        transactions;   /* Transactions addressed to this device */
+    uint32_t        bytes;          /* Bytes in those transactions, address included */
+    uint32_t        command_bytes;  /* Command and argument bytes */
+    uint32_t        data_bytes;     /* GDDRAM writes */
+    uint32_t        errors;         /* Malformed transactions and unknown commands */
+} ssd1306_emu_stats_t;
+
+typedef struct {
+    uint8_t         address;        /* 7-bit I2C address */
+    int             width;          /* Visible columns */
+    int             height;         /* Visible rows */
+
+    uint8_t         gddram[SSD1306_EMU_PAGES][SSD1306_EMU_COLUMNS];
+
+    /* Addressing */
+    uint8_t         addr_mode;
+    uint8_t         column_start;
+    uint8_t         column_end;
+    uint8_t         page_start;
+    uint8_t         page_end;
+    uint8_t         column;
+    uint8_t         page;
+    uint8_t         page_mode_column;   /* Column start in page addressing mode */
+
+    /* Hardware configuration */
+    uint8_t         start_line;
+    uint8_t         display_offset;
+    uint8_t         mux_ratio;
+    bool            segment_remap;
+    bool            com_remap;
+    uint8_t         contrast;
+    bool            display_on;
+    bool            entire_on;
+    bool            inverted;
+
+    /* Scrolling */
+    uint8_t         scroll_setup;       /* 0x26, 0x27, 0x29 or 0x2A */
+    uint8_t         scroll_start_page;
+    uint8_t         scroll_end_page;
+    uint16_t        scroll_interval;    /* Frames per step */
+    uint8_t         scroll_vertical;    /* Rows per step for the diagonal variants */
+    uint8_t         scroll_fixed_rows;  /* A3h: rows above the vertical scroll area */
+    uint8_t         scroll_rows;        /* A3h: rows in the vertical scroll area */
+    uint8_t         scroll_position;    /* Current vertical scroll offset */
+    uint32_t        scroll_frames;      /* Frames accumulated towards the next step */
+    bool            scroll_active;
+
+    /* Command parser state; persists across transactions like the real part */
+    uint8_t         command[8];
+    int             command_len;
+    int             command_args;
+
+    ssd1306_emu_stats_t stats;
+} ssd1306_emu_t;
+
+/* Power-on reset state; GDDRAM is filled with a pattern since its content is undefined */
+void ssd1306_emu_init(ssd1306_emu_t *emu, uint8_t address, int width, int height);
+
+/* Route transactions on a mock I2C port to the model */
+void ssd1306_emu_attach(ssd1306_emu_t *emu, int i2c_num);
+
+/* Feed one transaction (address byte first) */
+void ssd1306_emu_transaction(void *ctx, const uint8_t *data, size_t len);
+
+/* Advance the panel clock by a number of frames; only matters while scrolling */
+void ssd1306_emu_tick(ssd1306_emu_t *emu, uint32_t frames);
+
+/* Pixel as seen on the panel, after remapping, start line, scrolling and inversion */
+bool ssd1306_emu_pixel(const ssd1306_emu_t *emu, int x, int y);
+
+/* Write the panel image as a plain PBM */
+int  ssd1306_emu_write_pbm(const ssd1306_emu_t *emu, FILE *fp);
+
+/* Compare the visible part of GDDRAM with a page-major frame buffer of width x height */
+bool ssd1306_emu_matches(const ssd1306_emu_t *emu, const uint8_t *frame_buf, int width, int height);
+
+#endif /* __ssd1306_emu_h_included */
@@ -0,0 +1,1016 @@
+/*
+ * mkasset.c
+ *
+ * Converts fonts (BDF, PSF) and images (PBM, XBM) into C sources holding
+ * font_t and bitmap_t definitions, with the pixels already in SSD1306
+ * page-major order: 8-row bands, one byte per column, bit 0 the top row.
+ *
+ * Usage: mkasset [options] input
+ *
+ *   -n name        symbol to define (default: the input file's base name)
+ *   -o file.c      output source (default: stdout)
+ *   -H file.h      also write a header declaring the symbol
+ *   -p fixed       fonts: every glyph the width of the widest advance
+ *   -p variable    fonts: each glyph its own advance (default for BDF fonts
+ *                  whose advances differ)
+ *   -R codepoint   fonts: glyph drawn for missing characters (default: the
+ *                  BDF DEFAULT_CHAR, else none)
+ *   -i             images: set pixels for white instead of black PBM pixels
+ *   -c format      raw (default), rle, lz, or auto for the smallest; fonts
+ *                  compress each glyph on its own
+ *
+ * Fonts whose codepoints have gaps come out sparse (see font.h); a PSF
+ * unicode table can map several codepoints to one glyph.  The compressed
+ * formats are described in bitmap.h; they are drawn straight from the
+ * stream, so pick whichever is smallest for the asset.
+ */
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "font.h"
+
+#define MAX_GLYPHS      65535
+#define FORMAT_AUTO     -1
+
+static const char *format_names[] = { "raw", "rle", "lz" };
+
+/* A glyph as rows of pixels, one byte per pixel */
+typedef struct {
+    int         ch;
+    int         width;                  /* Advance */
+    uint8_t     *pixels;                /* height rows of width */
+    int         image;                  /* Codepoints with the same image share one glyph */
+} glyph_t;
+
+typedef struct {
+    int         width;                  /* Widest advance */
+    int         height;
+    int         count;
+    glyph_t     *glyphs;
+    bool        variable;               /* Advances differ */
+    int         default_ch;             /* -1 if none */
+    int         images;                 /* Distinct glyph images added */
+} font_src_t;
+
+typedef struct {
+    int         width;
+    int         height;
+    uint8_t     *pixels;
+} image_t;
+
+static const char *input_name;
+
+static void fail(const char *format, ...)
+{
+    va_list args;
+
+    fprintf(stderr, "mkasset: %s: ", input_name);
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+
+    exit(1);
+}
+
+static void *xcalloc(size_t count, size_t size)
+{
+    void *ptr = calloc(count ? count : 1, size ? size : 1);
+
+    if (ptr == NULL) {
+        fail("out of memory");
+    }
+
+    return ptr;
+}
+
+static uint8_t *read_file(const char *path, size_t *plength)
+{
+    FILE *fp = fopen(path, "rb");
+
+    if (fp == NULL) {
+        fail("cannot open");
+    }
+
+    size_t size = 4096;
+    size_t length = 0;
+    uint8_t *data = xcalloc(size + 1, 1);
+    size_t got;
+
+    while ((got = fread(data + length, 1, size - length, fp)) > 0) {
+        length += got;
+        if (length == size) {
+            size *= 2;
+            data = realloc(data, size + 1);
+            if (data == NULL) {
+                fail("out of memory");
+            }
+        }
+    }
+
+    fclose(fp);
+
+    data[length] = '\0';
+    *plength = length;
+
+    return data;
+}
+
+/* Room for one more glyph entry at the end */
+static glyph_t *new_glyph(font_src_t *font)
+{
+    if (font->count >= MAX_GLYPHS) {
+        fail("too many glyphs");
+    }
+
+    font->glyphs = realloc(font->glyphs, (font->count + 1) * sizeof(glyph_t));
+    if (font->glyphs == NULL) {
+        fail("out of memory");
+    }
+
+    return &font->glyphs[font->count++];
+}
+
+static glyph_t *add_glyph(font_src_t *font, int ch, int width)
+{
+    glyph_t *glyph = new_glyph(font);
+
+    glyph->ch     = ch;
+    glyph->width  = width;
+    glyph->pixels = xcalloc(width * font->height, 1);
+    glyph->image  = font->images++;
+
+    return glyph;
+}
+
+/* Another codepoint for the glyph entry at index of, sharing its image */
+static void add_alias(font_src_t *font, int ch, int of)
+{
+    glyph_t *glyph = new_glyph(font);
+
+    *glyph = font->glyphs[of];
+    glyph->ch = ch;
+}
+
+/*
+ * BDF: glyph boxes are placed on a common baseline FONT_ASCENT rows down, at
+ * their BBX offset from the origin; ink outside the advance is dropped.
+ */
+static void parse_bdf(font_src_t *font, char *text)
+{
+    int box_w = 0, box_h = 0, box_x = 0, box_y = 0;
+    int ascent = -1, descent = -1;
+    bool fixed_width = true;
+    char *line;
+    char *save;
+
+    font->default_ch = -1;
+
+    /* First pass: font-wide properties */
+    char *copy = strdup(text);
+
+    for (line = strtok_r(copy, "\n", &save); line != NULL; line = strtok_r(NULL, "\n", &save)) {
+        if (sscanf(line, "FONTBOUNDINGBOX %d %d %d %d", &box_w, &box_h, &box_x, &box_y) == 4) {
+            continue;
+        }
+        if (sscanf(line, "FONT_ASCENT %d", &ascent) == 1 || sscanf(line, "FONT_DESCENT %d", &descent) == 1) {
+            continue;
+        }
+        if (sscanf(line, "DEFAULT_CHAR %d", &font->default_ch) == 1) {
+            continue;
+        }
+        if (strncmp(line, "STARTCHAR", 9) == 0) {
+            break;
+        }
+    }
+
+    free(copy);
+
+    if (box_h <= 0) {
+        fail("no FONTBOUNDINGBOX");
+    }
+    if (ascent < 0 || descent < 0) {
+        ascent = box_h + box_y;
+        descent = -box_y;
+    }
+
+    font->height = ascent + descent;
+
+    if (font->height <= 0 || font->height > 255 || box_w > 255) {
+        fail("unsupported font size");
+    }
+
+    int ch = -1, advance = box_w;
+    int w = 0, h = 0, x = 0, y = 0;
+    int row = -1;
+    glyph_t *glyph = NULL;
+
+    for (line = strtok_r(text, "\n", &save); line != NULL; line = strtok_r(NULL, "\n", &save)) {
+        if (strncmp(line, "STARTCHAR", 9) == 0) {
+            ch = -1;
+            advance = box_w;
+            w = box_w, h = box_h, x = box_x, y = box_y;
+            row = -1;
+        } else if (sscanf(line, "ENCODING %d", &ch) == 1) {
+            continue;
+        } else if (sscanf(line, "DWIDTH %d", &advance) == 1) {
+            continue;
+        } else if (sscanf(line, "BBX %d %d %d %d", &w, &h, &x, &y) == 4) {
+            continue;
+        } else if (strncmp(line, "BITMAP", 6) == 0) {
+            /* Unencoded glyphs (ENCODING -1) are skipped */
+            if (advance < 0 || advance > 255) {
+                fail("unsupported advance %d", advance);
+            }
+
+            glyph = ch >= 0 ? add_glyph(font, ch, advance) : NULL;
+            row = 0;
+
+            if (glyph != NULL && font->count > 1 && advance != font->glyphs[0].width) {
+                fixed_width = false;
+            }
+            if (advance > font->width) {
+                font->width = advance;
+            }
+        } else if (strncmp(line, "ENDCHAR", 7) == 0) {
+            glyph = NULL;
+            row = -1;
+        } else if (row >= 0 && row < h) {
+            int top = ascent - (y + h) + row;
+
+            for (int col = 0; col < w && glyph != NULL; ++col) {
+                int nibble = line[col / 4];
+                int value = isdigit(nibble) ? nibble - '0' : toupper(nibble) - 'A' + 10;
+                int px = x + col;
+
+                if (!isxdigit(nibble)) {
+                    break;
+                }
+                if ((value >> (3 - col % 4)) & 1 && px >= 0 && px < glyph->width && top >= 0 && top < font->height) {
+                    glyph->pixels[top * glyph->width + px] = 1;
+                }
+            }
+            ++row;
+        }
+    }
+
+    font->variable = !fixed_width;
+}
+
+/* PSF: version 1 or 2, with or without a unicode table */
+static void parse_psf(font_src_t *font, const uint8_t *data, size_t length)
+{
+    int count, width, height, stride;
+    size_t header;
+    bool unicode;
+    bool psf2;
+
+    if (length >= 4 && data[0] == 0x36 && data[1] == 0x04) {
+        psf2    = false;
+        count   = data[2] & 0x01 ? 512 : 256;
+        unicode = (data[2] & 0x06) != 0;
+        height  = data[3];
+        width   = 8;
+        header  = 4;
+    } else if (length >= 32 && data[0] == 0x72 && data[1] == 0xB5 && data[2] == 0x4A && data[3] == 0x86) {
+        uint32_t field[8];
+
+        for (int index = 0; index < 8; ++index) {
+            field[index] = data[index * 4] | data[index * 4 + 1] << 8 | data[index * 4 + 2] << 16 | (uint32_t) data[index * 4 + 3] << 24;
+        }
+
+        psf2    = true;
+        header  = field[2];
+        unicode = field[3] & 0x01;
+        count   = field[4];
+        height  = field[6];
+        width   = field[7];
+    } else {
+        fail("not a PSF font");
+    }
+
+    if (width <= 0 || width > 255 || height <= 0 || height > 255) {
+        fail("unsupported glyph size %dx%d", width, height);
+    }
+
+    stride = (width + 7) / 8;
+
+    if (count <= 0 || count > MAX_GLYPHS || header + (size_t) count * stride * height > length) {
+        fail("truncated PSF font");
+    }
+
+    font->width      = width;
+    font->height     = height;
+    font->variable   = false;
+    font->default_ch = -1;
+
+    /* Codepoints per glyph: from the unicode table, else the glyph number */
+    const uint8_t *table = data + header + (size_t) count * stride * height;
+    const uint8_t *end = data + length;
+
+    for (int index = 0; index < count; ++index) {
+        const uint8_t *rows = data + header + (size_t) index * stride * height;
+        int codes[64];
+        int ncodes = 0;
+
+        if (!unicode) {
+            codes[ncodes++] = index;
+        } else if (!psf2) {
+            /* 16-bit entries up to 0xFFFF; 0xFFFE starts sequences, which are skipped */
+            bool sequence = false;
+
+            while (table + 1 < end) {
+                int code = table[0] | table[1] << 8;
+
+                table += 2;
+                if (code == 0xFFFF) {
+                    break;
+                }
+                if (code == 0xFFFE) {
+                    sequence = true;
+                } else if (!sequence && ncodes < 64) {
+                    codes[ncodes++] = code;
+                }
+            }
+        } else {
+            /* UTF-8 strings up to 0xFF; 0xFE starts sequences */
+            bool sequence = false;
+
+            while (table < end && *table != 0xFF) {
+                if (*table == 0xFE) {
+                    sequence = true;
+                    ++table;
+                    continue;
+                }
+
+                char buf[5] = { 0 };
+                const char *next = buf;
+                int len = 0;
+
+                while (len < 4 && table + len < end && table[len] != 0xFF && table[len] != 0xFE &&
+                       (len == 0 || (table[len] & 0xC0) == 0x80)) {
+                    buf[len] = table[len];
+                    ++len;
+                }
+
+                int code = text_next_char(&next);
+
+                table += next - buf > 0 ? next - buf : 1;
+
+                if (!sequence && ncodes < 64) {
+                    codes[ncodes++] = code;
+                }
+            }
+            ++table;
+        }
+
+        if (ncodes == 0) {
+            continue;
+        }
+
+        /* One glyph, every further codepoint an alias of it */
+        glyph_t *glyph = add_glyph(font, codes[0], width);
+        int first = font->count - 1;
+
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                glyph->pixels[y * width + x] = (rows[y * stride + x / 8] >> (7 - x % 8)) & 1;
+            }
+        }
+
+        for (int code = 1; code < ncodes; ++code) {
+            add_alias(font, codes[code], first);
+        }
+    }
+}
+
+static const char *pbm_token(const char *text, int *value)
+{
+    while (*text != '\0') {
+        if (*text == '#') {
+            while (*text != '\0' && *text != '\n') {
+                ++text;
+            }
+        } else if (isspace((unsigned char) *text)) {
+            ++text;
+        } else {
+            break;
+        }
+    }
+
+    if (!isdigit((unsigned char) *text)) {
+        fail("malformed PBM");
+    }
+
+    *value = (int) strtol(text, (char **) &text, 10);
+
+    return text;
+}
+
+/* PBM: plain (P1) or raw (P4); black pixels are set unless inverted */
+static void parse_pbm(image_t *image, const uint8_t *data, size_t length, bool invert)
+{
+    const char *text = (const char *) data + 2;
+    bool raw = data[1] == '4';
+
+    text = pbm_token(text, &image->width);
+    text = pbm_token(text, &image->height);
+
+    if (image->width <= 0 || image->height <= 0 || image->width > 4096 || image->height > 4096) {
+        fail("unsupported image size");
+    }
+
+    image->pixels = xcalloc((size_t) image->width * image->height, 1);
+
+    if (raw) {
+        /* One whitespace byte, then rows of packed bits, leftmost in the high bit */
+        const uint8_t *bits = (const uint8_t *) text + 1;
+        int stride = (image->width + 7) / 8;
+
+        if (bits + (size_t) stride * image->height > data + length) {
+            fail("truncated PBM");
+        }
+
+        for (int y = 0; y < image->height; ++y) {
+            for (int x = 0; x < image->width; ++x) {
+                image->pixels[y * image->width + x] = ((bits[y * stride + x / 8] >> (7 - x % 8)) & 1) ^ invert;
+            }
+        }
+    } else {
+        for (int index = 0; index < image->width * image->height; ++index) {
+            while (*text != '\0' && *text != '0' && *text != '1') {
+                ++text;
+            }
+            if (*text == '\0') {
+                fail("truncated PBM");
+            }
+            image->pixels[index] = (*text++ == '1') ^ invert;
+        }
+    }
+}
+
+/* XBM: the C source form, rows of bytes with the leftmost pixel in the low bit */
+static void parse_xbm(image_t *image, const char *text)
+{
+    const char *width = strstr(text, "_width");
+    const char *height = strstr(text, "_height");
+    const char *bits = strchr(text, '{');
+
+    if (width == NULL || height == NULL || bits == NULL) {
+        fail("malformed XBM");
+    }
+
+    image->width  = atoi(width + 6);
+    image->height = atoi(height + 7);
+
+    if (image->width <= 0 || image->height <= 0 || image->width > 4096 || image->height > 4096) {
+        fail("unsupported image size");
+    }
+    image->pixels = xcalloc((size_t) image->width * image->height, 1);
+
+    int stride = (image->width + 7) / 8;
+
+    for (int index = 0; index < stride * image->height; ++index) {
+        bits = strstr(bits, "0x");
+        if (bits == NULL) {
+            fail("truncated XBM");
+        }
+
+        int value = (int) strtol(bits, (char **) &bits, 16);
+        int y = index / stride;
+
+        for (int bit = 0; bit < 8; ++bit) {
+            int x = (index % stride) * 8 + bit;
+
+            if (x < image->width) {
+                image->pixels[y * image->width + x] = (value >> bit) & 1;
+            }
+        }
+    }
+}
+
+/* Page-major bytes of a pixel block into dst: pages rows of width bytes, bit 0 on top */
+static int pack_pages(const uint8_t *pixels, int width, int height, uint8_t *dst)
+{
+    int length = 0;
+
+    for (int page = 0; page < (height + 7) / 8; ++page) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t byte = 0;
+
+            for (int bit = 0; bit < 8 && page * 8 + bit < height; ++bit) {
+                byte |= pixels[(page * 8 + bit) * width + x] << bit;
+            }
+
+            dst[length++] = byte;
+        }
+    }
+
+    return length;
+}
+
+/* Array initializer bytes, twelve to a line; count runs on across calls */
+static void emit_bytes(FILE *out, const uint8_t *bytes, int length, int *count)
+{
+    for (int index = 0; index < length; ++index) {
+        fprintf(out, "%s0x%02X,", *count % 12 == 0 ? "\n    " : " ", bytes[index]);
+        ++*count;
+    }
+}
+
+/* PackBits-style runs, see bitmap.h */
+static int rle_pack(const uint8_t *src, int length, uint8_t *dst)
+{
+    int out = 0;
+    int index = 0;
+
+    while (index < length) {
+        int run = 1;
+
+        while (index + run < length && run < 129 && src[index + run] == src[index]) {
+            ++run;
+        }
+
+        if (run >= 2) {
+            dst[out++] = 0x80 + run - 2;
+            dst[out++] = src[index];
+            index += run;
+        } else {
+            /* Literals up to the next pair of equal bytes */
+            int start = index;
+
+            while (index < length && index - start < 128 &&
+                   !(index + 1 < length && src[index] == src[index + 1])) {
+                ++index;
+            }
+
+            dst[out++] = index - start - 1;
+            memcpy(&dst[out], &src[start], index - start);
+            out += index - start;
+        }
+    }
+
+    return out;
+}
+
+/*
+ * LZ with a 256 byte window, see bitmap.h: greedy, taking the longest match
+ * of 3 to 258 bytes at each position.  Matches may overlap their own output.
+ */
+static int lz_pack(const uint8_t *src, int length, uint8_t *dst)
+{
+    int out = 0;
+    int flags_at = 0;
+    int items = 8;
+
+    for (int index = 0; index < length; ++items) {
+        if (items == 8) {
+            flags_at = out;
+            dst[out++] = 0;
+            items = 0;
+        }
+
+        int best = 0;
+        int distance = 0;
+
+        for (int from = index - 1; from >= 0 && from >= index - 256; --from) {
+            int match = 0;
+
+            while (index + match < length && match < 258 && src[from + match] == src[index + match]) {
+                ++match;
+            }
+
+            if (match > best) {
+                best = match;
+                distance = index - from;
+            }
+        }
+
+        if (best >= 3) {
+            dst[flags_at] |= 1 << items;
+            dst[out++] = distance - 1;
+            dst[out++] = best - 3;
+            index += best;
+        } else {
+            dst[out++] = src[index++];
+        }
+    }
+
+    return out;
+}
+
+/* Size of src in format; dst needs room for 2 * length + 1 bytes */
+static int pack(int format, const uint8_t *src, int length, uint8_t *dst)
+{
+    if (format == bitmap_format_rle) {
+        return rle_pack(src, length, dst);
+    } else if (format == bitmap_format_lz) {
+        return lz_pack(src, length, dst);
+    }
+
+    memcpy(dst, src, length);
+
+    return length;
+}
+
+static int compare_glyphs(const void *a, const void *b)
+{
+    return ((const glyph_t *) a)->ch - ((const glyph_t *) b)->ch;
+}
+
+static void write_font(FILE *out, const char *name, font_src_t *font, const char *pitch, int replacement, int format)
+{
+    bool variable = pitch != NULL ? strcmp(pitch, "variable") == 0 : font->variable;
+
+    qsort(font->glyphs, font->count, sizeof(glyph_t), compare_glyphs);
+
+    /* Drop duplicate codepoints, keeping the first */
+    int count = 0;
+
+    for (int index = 0; index < font->count; ++index) {
+        if (count == 0 || font->glyphs[index].ch != font->glyphs[count - 1].ch) {
+            font->glyphs[count++] = font->glyphs[index];
+        }
+    }
+    font->count = count;
+
+    if (count == 0) {
+        fail("no glyphs");
+    }
+
+    /*
+     * Glyph numbers in codepoint order of each image's first codepoint; aliases
+     * share their image's number.  unique[n] is the codepoint entry for glyph n.
+     */
+    int *numbers = xcalloc(count, sizeof(int));
+    int *unique = xcalloc(count, sizeof(int));
+    int *image_numbers = xcalloc(font->images, sizeof(int));
+    int glyphs = 0;
+
+    for (int image = 0; image < font->images; ++image) {
+        image_numbers[image] = -1;
+    }
+
+    for (int index = 0; index < count; ++index) {
+        int *number = &image_numbers[font->glyphs[index].image];
+
+        if (*number < 0) {
+            unique[glyphs] = index;
+            *number = glyphs++;
+        }
+        numbers[index] = *number;
+    }
+
+    free(image_numbers);
+
+    int first = font->glyphs[0].ch;
+    int last = font->glyphs[count - 1].ch;
+    bool sparse = last - first + 1 != count || glyphs != count;
+    int pages = (font->height + 7) / 8;
+
+    if (replacement < 0) {
+        replacement = font->default_ch;
+    }
+
+    /* Glyph pages, widened to the fixed pitch where needed */
+    uint8_t **raw = xcalloc(glyphs, sizeof(uint8_t *));
+    int *lengths = xcalloc(glyphs, sizeof(int));
+    int *offsets = xcalloc(glyphs, sizeof(int));
+
+    for (int index = 0; index < glyphs; ++index) {
+        glyph_t *glyph = &font->glyphs[unique[index]];
+        int width = variable ? glyph->width : font->width;
+        uint8_t *pixels = xcalloc((size_t) width * font->height, 1);
+
+        for (int y = 0; y < font->height; ++y) {
+            for (int x = 0; x < width && x < glyph->width; ++x) {
+                pixels[y * width + x] = glyph->pixels[y * glyph->width + x];
+            }
+        }
+
+        glyph->width = width;
+        raw[index] = xcalloc((size_t) width * pages, 1);
+        lengths[index] = pack_pages(pixels, width, font->height, raw[index]);
+        free(pixels);
+    }
+
+    int widest = font->width * pages;
+    uint8_t *packed = xcalloc(2 * widest + 1, 1);
+
+    /* Compressed glyphs need the index too, so count it against them */
+    if (format == FORMAT_AUTO) {
+        int best = 0;
+
+        for (int candidate = bitmap_format_raw; candidate <= bitmap_format_lz; ++candidate) {
+            int size = variable || candidate != bitmap_format_raw ? glyphs * (int) sizeof(font_glyph_t) : 0;
+
+            for (int index = 0; index < glyphs; ++index) {
+                size += pack(candidate, raw[index], lengths[index], packed);
+            }
+
+            if (candidate == bitmap_format_raw || size < best) {
+                best = size;
+                format = candidate;
+            }
+        }
+    }
+
+    bool indexed = variable || format != bitmap_format_raw;
+    int bytes = 0;
+
+    if (format != bitmap_format_raw) {
+        fprintf(out, "/* %s, each glyph on its own */\n", format_names[format]);
+    }
+    fprintf(out, "static const uint8_t %s_data[] = {", name);
+
+    for (int index = 0; index < glyphs; ++index) {
+        if (indexed && (bytes > 0xFFFF || font->glyphs[unique[index]].width > 0xFF)) {
+            fail("indexed fonts are limited to 64 KiB and 255 columns a glyph");
+        }
+
+        offsets[index] = bytes;
+        emit_bytes(out, packed, pack(format, raw[index], lengths[index], packed), &bytes);
+        free(raw[index]);
+    }
+
+    fprintf(out, "\n};\n\n");
+
+    if (indexed) {
+        fprintf(out, "static const font_glyph_t %s_glyphs[] = {\n", name);
+        for (int index = 0; index < glyphs; ++index) {
+            const glyph_t *glyph = &font->glyphs[unique[index]];
+
+            fprintf(out, "    { %5d, %3d },   /* U+%04X */\n", offsets[index], glyph->width, glyph->ch);
+        }
+        fprintf(out, "};\n\n");
+    }
+
+    free(raw);
+    free(lengths);
+    free(offsets);
+    free(packed);
+    free(unique);
+
+    int first_block = first / FONT_MAP_BLOCK;
+    int blocks = last / FONT_MAP_BLOCK - first_block + 1;
+    int rows = 0;
+
+    if (sparse) {
+        uint8_t *block_rows = xcalloc(blocks, 1);
+
+        fprintf(out, "#define NONE FONT_MAP_NONE\n\n");
+        fprintf(out, "static const uint16_t %s_map[][FONT_MAP_BLOCK] = {\n", name);
+
+        for (int block = 0, index = 0; block < blocks; ++block) {
+            int base = (first_block + block) * FONT_MAP_BLOCK;
+
+            if (index >= count || font->glyphs[index].ch >= base + FONT_MAP_BLOCK) {
+                continue;
+            }
+
+            if (rows == 0xFF) {
+                fail("too many map blocks for a sparse font");
+            }
+            block_rows[block] = ++rows;
+
+            fprintf(out, "    /* U+%04X - U+%04X */ {", base, base + FONT_MAP_BLOCK - 1);
+
+            for (int ch = base; ch < base + FONT_MAP_BLOCK; ++ch) {
+                const char *separator = (ch - base) % 16 == 0 ? "\n        " : " ";
+
+                if (index < count && font->glyphs[index].ch == ch) {
+                    fprintf(out, "%s%4d,", separator, numbers[index++]);
+                } else {
+                    fprintf(out, "%sNONE,", separator);
+                }
+            }
+
+            fprintf(out, "\n    },\n");
+        }
+
+        fprintf(out, "};\n\n#undef NONE\n\nstatic const uint8_t %s_blocks[] = {", name);
+        for (int block = 0; block < blocks; ++block) {
+            fprintf(out, "%s%d,", block % 16 == 0 ? "\n    " : " ", block_rows[block]);
+        }
+        fprintf(out, "\n};\n\n");
+
+        free(block_rows);
+    }
+
+    free(numbers);
+
+    bool has_space = false;
+
+    for (int index = 0; index < count; ++index) {
+        has_space |= font->glyphs[index].ch == ' ';
+    }
+
+    fprintf(out, "const font_t %s = {\n", name);
+    fprintf(out, "    .base         = (uint8_t *) %s_data,\n", name);
+    fprintf(out, "    .flags        = %s%s,\n", variable ? "font_flag_variable" : "font_flag_fixed", sparse ? " | font_flag_sparse" : "");
+    fprintf(out, "    .first_ch     = 0x%02X,\n", first);
+    fprintf(out, "    .last_ch      = 0x%02X,\n", last);
+    if (!has_space) {
+        fprintf(stderr, "mkasset: %s: warning: no glyph for U+0020, space_ch left 0\n", input_name);
+    }
+
+    fprintf(out, "    .space_ch     = 0x%02X,\n", has_space ? ' ' : 0);
+    fprintf(out, "    .width        = %d,\n", font->width);
+    fprintf(out, "    .height       = %d,\n", font->height);
+    if (indexed) {
+        fprintf(out, "    .glyphs       = %s_glyphs,\n", name);
+    }
+    if (sparse) {
+        fprintf(out, "    .map_blocks   = %s_blocks,\n", name);
+        fprintf(out, "    .map          = %s_map,\n", name);
+    }
+    if (replacement > 0) {
+        fprintf(out, "    .replacement_ch = 0x%02X,\n", replacement);
+    }
+    if (format != bitmap_format_raw) {
+        fprintf(out, "    .format       = bitmap_format_%s,\n", format_names[format]);
+    }
+    fprintf(out, "};\n");
+}
+
+static void write_image(FILE *out, const char *name, const image_t *image, int format)
+{
+    int length = image->width * ((image->height + 7) / 8);
+    uint8_t *raw = xcalloc(length, 1);
+    uint8_t *packed = xcalloc(2 * length + 1, 1);   /* Worst case: one-byte literals */
+    int size;
+
+    pack_pages(image->pixels, image->width, image->height, raw);
+
+    if (format == FORMAT_AUTO) {
+        format = bitmap_format_raw;
+
+        for (int candidate = bitmap_format_rle; candidate <= bitmap_format_lz; ++candidate) {
+            if (pack(candidate, raw, length, packed) < pack(format, raw, length, packed)) {
+                format = candidate;
+            }
+        }
+    }
+
+    size = pack(format, raw, length, packed);
+
+    int bytes = 0;
+
+    if (format != bitmap_format_raw) {
+        fprintf(out, "/* %s: %d bytes from %d */\n", format_names[format], size, length);
+    }
+    fprintf(out, "static const uint8_t %s_bits[] = {", name);
+    emit_bytes(out, packed, size, &bytes);
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "bitmap_t %s = {\n", name);
+    fprintf(out, "    .width  = %d,\n", image->width);
+    fprintf(out, "    .height = %d,\n", image->height);
+    fprintf(out, "    .bits   = (uint8_t *) %s_bits,\n", name);
+    if (format != bitmap_format_raw) {
+        fprintf(out, "    .format = bitmap_format_%s,\n", format_names[format]);
+    }
+    fprintf(out, "};\n");
+
+    free(raw);
+    free(packed);
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: mkasset [-n name] [-o file.c] [-H file.h] [-p fixed|variable] [-R codepoint] [-i] [-c raw|rle|lz|auto] input\n");
+    exit(2);
+}
+
+static int parse_format(const char *text)
+{
+    for (int format = bitmap_format_raw; format <= bitmap_format_lz; ++format) {
+        if (strcmp(text, format_names[format]) == 0) {
+            return format;
+        }
+    }
+
+    if (strcmp(text, "auto") != 0) {
+        usage();
+    }
+
+    return FORMAT_AUTO;
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = NULL;
+    const char *output = NULL;
+    const char *header = NULL;
+    const char *pitch = NULL;
+    int replacement = -1;
+    bool invert = false;
+    int format = bitmap_format_raw;
+    int option;
+
+    while ((option = getopt(argc, argv, "n:o:H:p:R:ic:")) != -1) {
+        switch (option) {
+            case 'n': name = optarg; break;
+            case 'o': output = optarg; break;
+            case 'H': header = optarg; break;
+            case 'p': pitch = optarg; break;
+            case 'R': replacement = (int) strtol(optarg, NULL, 0); break;
+            case 'i': invert = true; break;
+            case 'c': format = parse_format(optarg); break;
+            default:  usage();
+        }
+    }
+
+    if (optind + 1 != argc || (pitch != NULL && strcmp(pitch, "fixed") != 0 && strcmp(pitch, "variable") != 0)) {
+        usage();
+    }
+
+    input_name = argv[optind];
+
+    /* Symbol from the base name: letters, digits and underscores */
+    char symbol[64];
+
+    if (name == NULL) {
+        const char *base = strrchr(input_name, '/') != NULL ? strrchr(input_name, '/') + 1 : input_name;
+        size_t length = 0;
+
+        for (; base[length] != '\0' && base[length] != '.' && length < sizeof(symbol) - 1; ++length) {
+            symbol[length] = isalnum((unsigned char) base[length]) ? base[length] : '_';
+        }
+        symbol[length] = '\0';
+        name = symbol;
+    }
+
+    size_t length;
+    uint8_t *data = read_file(input_name, &length);
+    bool is_font;
+    font_src_t font = { 0 };
+    image_t image = { 0 };
+
+    if (strncmp((char *) data, "STARTFONT", 9) == 0) {
+        is_font = true;
+        parse_bdf(&font, (char *) data);
+    } else if ((length >= 2 && data[0] == 0x36 && data[1] == 0x04) || (length >= 4 && memcmp(data, "\x72\xB5\x4A\x86", 4) == 0)) {
+        is_font = true;
+        parse_psf(&font, data, length);
+    } else if (length >= 2 && data[0] == 'P' && (data[1] == '1' || data[1] == '4')) {
+        is_font = false;
+        parse_pbm(&image, data, length, invert);
+    } else if (strstr((char *) data, "_bits[]") != NULL) {
+        is_font = false;
+        parse_xbm(&image, (char *) data);
+    } else {
+        fail("unknown format; expected BDF, PSF, PBM or XBM");
+    }
+
+    FILE *out = output != NULL ? fopen(output, "w") : stdout;
+
+    if (out == NULL) {
+        perror(output);
+        return 1;
+    }
+
+    fprintf(out, "/*\n * Generated by mkasset from %s; do not edit.\n */\n", input_name);
+    fprintf(out, "#include \"%s\"\n\n", is_font ? "font.h" : "bitmap.h");
+
+    if (is_font) {
+        write_font(out, name, &font, pitch, replacement, format);
+    } else {
+        write_image(out, name, &image, format);
+    }
+
+    if (output != NULL && fclose(out) != 0) {
+        perror(output);
+        return 1;
+    }
+
+    if (header != NULL) {
+        FILE *fp = fopen(header, "w");
+
+        if (fp == NULL) {
+            perror(header);
+            return 1;
+        }
+
+        fprintf(fp, "/*\n * Generated by mkasset from %s; do not edit.\n */\n", input_name);
+        fprintf(fp, "#ifndef __%s_h_included\n#define __%s_h_included\n\n", name, name);
+        fprintf(fp, "#include \"%s\"\n\n", is_font ? "font.h" : "bitmap.h");
+        if (is_font) {
+            fprintf(fp, "extern const font_t %s;\n", name);
+        } else {
+            fprintf(fp, "extern bitmap_t %s;\n", name);
+        }
+        fprintf(fp, "\n#endif /* __%s_h_included */\n", name);
+        fclose(fp);
+    }
+
+    free(data);
+
+    return 0;
+}
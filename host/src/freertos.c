@@ -0,0 +1,518 @@
+/*
+ * freertos.c
+ *
+ * Host shim: FreeRTOS tasks, semaphores, notifications and event groups on
+ * pthreads.  Timeouts are converted from ticks to wall-clock time; the tick
+ * count itself is virtual and only advanced by vTaskDelay.
+ */
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+typedef enum {
+    host_semaphore_recursive,
+    host_semaphore_mutex,
+    host_semaphore_binary,
+} host_semaphore_type_t;
+
+struct host_semaphore {
+    host_semaphore_type_t   type;
+    bool                    is_static;
+    pthread_mutex_t         mutex;
+    pthread_cond_t          cond;
+    int                     count;      /* Binary: available; mutexes: hold depth */
+    pthread_t               owner;
+};
+
+struct host_task {
+    pthread_t               thread;
+    TaskFunction_t          code;
+    void                    *param;
+    bool                    is_static;
+    bool                    suspended;
+
+    pthread_mutex_t         mutex;
+    pthread_cond_t          cond;
+    uint32_t                notify;
+};
+
+struct host_event_group {
+    bool                    is_static;
+    pthread_mutex_t         mutex;
+    pthread_cond_t          cond;
+    EventBits_t             bits;
+};
+
+_Static_assert(sizeof(struct host_semaphore) <= sizeof(StaticSemaphore_t), "StaticSemaphore_t too small");
+_Static_assert(sizeof(struct host_task) <= sizeof(StaticTask_t), "StaticTask_t too small");
+_Static_assert(sizeof(struct host_event_group) <= sizeof(StaticEventGroup_t), "StaticEventGroup_t too small");
+
+static TickType_t tick_count;
+
+static __thread struct host_task *current_task;
+
+/* Absolute deadline for a wait of 'ticks'; false when waiting forever */
+static bool host_deadline(TickType_t ticks, struct timespec *deadline)
+{
+    if (ticks == portMAX_DELAY) {
+        return false;
+    }
+
+    uint64_t ns = (uint64_t) ticks * (1000000000ULL / CONFIG_FREERTOS_HZ);
+
+    clock_gettime(CLOCK_REALTIME, deadline);
+
+    deadline->tv_sec  += ns / 1000000000ULL;
+    deadline->tv_nsec += ns % 1000000000ULL;
+
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+
+    return true;
+}
+
+/* Wait on cond; returns false on timeout */
+static bool host_wait(pthread_cond_t *cond, pthread_mutex_t *mutex, bool timed, const struct timespec *deadline)
+{
+    if (!timed) {
+        pthread_cond_wait(cond, mutex);
+        return true;
+    }
+
+    return pthread_cond_timedwait(cond, mutex, deadline) != ETIMEDOUT;
+}
+
+/*
+ * Semaphores
+ */
+static SemaphoreHandle_t host_semaphore_init(struct host_semaphore *sem, host_semaphore_type_t type, bool is_static)
+{
+    if (sem != NULL) {
+        memset(sem, 0, sizeof(*sem));
+
+        sem->type = type;
+        sem->is_static = is_static;
+        sem->count = 0;
+
+        pthread_mutex_init(&sem->mutex, NULL);
+        pthread_cond_init(&sem->cond, NULL);
+    }
+
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+    return host_semaphore_init((struct host_semaphore *) malloc(sizeof(struct host_semaphore)), host_semaphore_recursive, false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic(StaticSemaphore_t *buffer)
+{
+    return host_semaphore_init((struct host_semaphore *) buffer, host_semaphore_recursive, true);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return host_semaphore_init((struct host_semaphore *) malloc(sizeof(struct host_semaphore)), host_semaphore_mutex, false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer)
+{
+    return host_semaphore_init((struct host_semaphore *) buffer, host_semaphore_mutex, true);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return host_semaphore_init((struct host_semaphore *) malloc(sizeof(struct host_semaphore)), host_semaphore_binary, false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buffer)
+{
+    return host_semaphore_init((struct host_semaphore *) buffer, host_semaphore_binary, true);
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks_to_wait)
+{
+    struct timespec deadline;
+    bool timed = host_deadline(ticks_to_wait, &deadline);
+    BaseType_t taken = pdTRUE;
+
+    pthread_mutex_lock(&sem->mutex);
+
+    if (sem->count == 0 || !pthread_equal(sem->owner, pthread_self())) {
+        while (sem->count != 0 && taken) {
+            taken = host_wait(&sem->cond, &sem->mutex, timed, &deadline);
+        }
+        if (taken) {
+            sem->owner = pthread_self();
+        }
+    }
+
+    if (taken) {
+        sem->count++;
+    }
+
+    pthread_mutex_unlock(&sem->mutex);
+
+    return taken;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem)
+{
+    BaseType_t given = pdFALSE;
+
+    pthread_mutex_lock(&sem->mutex);
+
+    if (sem->count != 0 && pthread_equal(sem->owner, pthread_self())) {
+        if (--sem->count == 0) {
+            pthread_cond_signal(&sem->cond);
+        }
+        given = pdTRUE;
+    }
+
+    pthread_mutex_unlock(&sem->mutex);
+
+    return given;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait)
+{
+    if (sem->type != host_semaphore_binary) {
+        return xSemaphoreTakeRecursive(sem, ticks_to_wait);
+    }
+
+    struct timespec deadline;
+    bool timed = host_deadline(ticks_to_wait, &deadline);
+    BaseType_t taken = pdTRUE;
+
+    pthread_mutex_lock(&sem->mutex);
+
+    while (sem->count == 0 && taken) {
+        taken = ticks_to_wait != 0 && host_wait(&sem->cond, &sem->mutex, timed, &deadline);
+    }
+
+    if (taken) {
+        sem->count = 0;
+    }
+
+    pthread_mutex_unlock(&sem->mutex);
+
+    return taken;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem->type != host_semaphore_binary) {
+        return xSemaphoreGiveRecursive(sem);
+    }
+
+    BaseType_t given;
+
+    pthread_mutex_lock(&sem->mutex);
+
+    given = sem->count == 0;
+    sem->count = 1;
+    pthread_cond_signal(&sem->cond);
+
+    pthread_mutex_unlock(&sem->mutex);
+
+    return given;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    if (sem != NULL) {
+        pthread_mutex_destroy(&sem->mutex);
+        pthread_cond_destroy(&sem->cond);
+
+        if (!sem->is_static) {
+            free(sem);
+        }
+    }
+}
+
+/*
+ * Tasks
+ */
+static struct host_task *host_current_task(void)
+{
+    if (current_task == NULL) {
+        /* A thread not started through xTaskCreate (e.g. main) */
+        current_task = (struct host_task *) calloc(1, sizeof(struct host_task));
+        current_task->thread = pthread_self();
+        pthread_mutex_init(&current_task->mutex, NULL);
+        pthread_cond_init(&current_task->cond, NULL);
+    }
+
+    return current_task;
+}
+
+static void *host_task_entry(void *arg)
+{
+    struct host_task *task = (struct host_task *) arg;
+
+    current_task = task;
+
+    task->code(task->param);
+
+    return NULL;
+}
+
+static TaskHandle_t host_task_start(struct host_task *task, TaskFunction_t code, void *param, bool is_static)
+{
+    memset(task, 0, sizeof(*task));
+
+    task->code = code;
+    task->param = param;
+    task->is_static = is_static;
+
+    pthread_mutex_init(&task->mutex, NULL);
+    pthread_cond_init(&task->cond, NULL);
+
+    if (pthread_create(&task->thread, NULL, host_task_entry, task) != 0) {
+        return NULL;
+    }
+
+    return task;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stack_depth, void *param, UBaseType_t priority, TaskHandle_t *handle)
+{
+    struct host_task *task = (struct host_task *) malloc(sizeof(struct host_task));
+
+    if (task == NULL || host_task_start(task, code, param, false) == NULL) {
+        free(task);
+        return pdFAIL;
+    }
+
+    if (handle != NULL) {
+        *handle = task;
+    }
+
+    return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t code, const char *name, uint32_t stack_depth, void *param, UBaseType_t priority, StackType_t *stack, StaticTask_t *task)
+{
+    return host_task_start((struct host_task *) task, code, param, true);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL || task == current_task) {
+        struct host_task *self = current_task;
+
+        current_task = NULL;
+
+        pthread_detach(pthread_self());
+
+        if (self != NULL && !self->is_static) {
+            free(self);
+        }
+
+        pthread_exit(NULL);
+    }
+
+    /* Only suspended tasks can be deleted by others: they hold no locks */
+    pthread_cancel(task->thread);
+    pthread_join(task->thread, NULL);
+
+    pthread_cond_destroy(&task->cond);
+    pthread_mutex_destroy(&task->mutex);
+
+    if (!task->is_static) {
+        free(task);
+    }
+}
+
+void vTaskSuspend(TaskHandle_t task)
+{
+    /* Only self-suspension is supported; the task stays put until deleted */
+    struct host_task *self = host_current_task();
+
+    __atomic_store_n(&self->suspended, true, __ATOMIC_RELEASE);
+
+    while (true) {
+        pause();
+    }
+}
+
+eTaskState eTaskGetState(TaskHandle_t task)
+{
+    if (task == current_task) {
+        return eRunning;
+    }
+
+    return __atomic_load_n(&task->suspended, __ATOMIC_ACQUIRE) ? eSuspended : eBlocked;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    __atomic_add_fetch(&tick_count, ticks, __ATOMIC_RELAXED);
+
+    sched_yield();
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return __atomic_load_n(&tick_count, __ATOMIC_RELAXED);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return host_current_task();
+}
+
+void host_task_yield(void)
+{
+    sched_yield();
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->mutex);
+    task->notify++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->mutex);
+
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    struct host_task *task = host_current_task();
+    struct timespec deadline;
+    bool timed = host_deadline(ticks_to_wait, &deadline);
+    bool waiting = ticks_to_wait != 0;
+    uint32_t value;
+
+    pthread_mutex_lock(&task->mutex);
+
+    while (task->notify == 0 && waiting) {
+        waiting = host_wait(&task->cond, &task->mutex, timed, &deadline);
+    }
+
+    value = task->notify;
+
+    if (value != 0) {
+        task->notify = clear_on_exit ? 0 : value - 1;
+    }
+
+    pthread_mutex_unlock(&task->mutex);
+
+    return value;
+}
+
+/*
+ * Event groups
+ */
+static EventGroupHandle_t host_event_group_init(struct host_event_group *group, bool is_static)
+{
+    if (group != NULL) {
+        memset(group, 0, sizeof(*group));
+
+        group->is_static = is_static;
+
+        pthread_mutex_init(&group->mutex, NULL);
+        pthread_cond_init(&group->cond, NULL);
+    }
+
+    return group;
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    return host_event_group_init((struct host_event_group *) malloc(sizeof(struct host_event_group)), false);
+}
+
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *buffer)
+{
+    return host_event_group_init((struct host_event_group *) buffer, true);
+}
+
+void vEventGroupDelete(EventGroupHandle_t group)
+{
+    if (group != NULL) {
+        pthread_mutex_destroy(&group->mutex);
+        pthread_cond_destroy(&group->cond);
+
+        if (!group->is_static) {
+            free(group);
+        }
+    }
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    EventBits_t result;
+
+    pthread_mutex_lock(&group->mutex);
+    group->bits |= bits;
+    result = group->bits;
+    pthread_cond_broadcast(&group->cond);
+    pthread_mutex_unlock(&group->mutex);
+
+    return result;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    EventBits_t result;
+
+    pthread_mutex_lock(&group->mutex);
+    result = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&group->mutex);
+
+    return result;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    EventBits_t result;
+
+    pthread_mutex_lock(&group->mutex);
+    result = group->bits;
+    pthread_mutex_unlock(&group->mutex);
+
+    return result;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit, BaseType_t wait_for_all, TickType_t ticks_to_wait)
+{
+    struct timespec deadline;
+    bool timed = host_deadline(ticks_to_wait, &deadline);
+    bool waiting = ticks_to_wait != 0;
+    EventBits_t result;
+
+    pthread_mutex_lock(&group->mutex);
+
+    for (;;) {
+        bool satisfied = wait_for_all ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+
+        if (satisfied || !waiting) {
+            result = group->bits;
+
+            if (satisfied && clear_on_exit) {
+                group->bits &= ~bits;
+            }
+            break;
+        }
+
+        waiting = host_wait(&group->cond, &group->mutex, timed, &deadline);
+    }
+
+    pthread_mutex_unlock(&group->mutex);
+
+    return result;
+}
@@ -0,0 +1,31 @@
+/*
+ * gpio.c
+ *
+ * Host shim: remembers output levels so callers can inspect e.g. the reset pin.
+ */
+#include "driver/gpio.h"
+
+#define HOST_GPIO_COUNT     64
+
+static uint8_t levels[HOST_GPIO_COUNT];
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    return config != NULL ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (gpio_num < 0 || gpio_num >= HOST_GPIO_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    levels[gpio_num] = level != 0;
+
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    return gpio_num >= 0 && gpio_num < HOST_GPIO_COUNT ? levels[gpio_num] : 0;
+}
@@ -0,0 +1,310 @@
+/*
+ * i2c.c
+ *
+ * Host shim: in-memory I2C command links and the mock bus they execute on.
+ */
+#include <string.h>
+#include <pthread.h>
+
+#include "driver/i2c.h"
+#include "host_i2c.h"
+
+typedef enum {
+    host_i2c_op_start,
+    host_i2c_op_stop,
+    host_i2c_op_byte,
+    host_i2c_op_data,
+} host_i2c_op_type_t;
+
+typedef struct {
+    uint8_t                 type;
+    uint8_t                 byte;
+    const uint8_t           *data;
+    size_t                  len;
+} host_i2c_op_t;
+
+typedef struct {
+    host_i2c_op_t           *ops;
+    size_t                  count;
+    size_t                  capacity;
+    bool                    is_static;
+} host_i2c_link_t;
+
+typedef struct {
+    pthread_mutex_t         mutex;
+    uint32_t                clk_speed;
+    bool                    installed;
+
+    host_i2c_device_t       device;
+    void                    *ctx;
+
+    /* Transaction being assembled */
+    uint8_t                 *buf;
+    size_t                  len;
+    size_t                  size;
+
+    host_i2c_stats_t        stats;
+} host_i2c_port_t;
+
+static host_i2c_port_t ports[I2C_NUM_MAX] = {
+    { .mutex = PTHREAD_MUTEX_INITIALIZER, .clk_speed = 100000 },
+    { .mutex = PTHREAD_MUTEX_INITIALIZER, .clk_speed = 100000 },
+};
+
+static uint32_t link_allocs;
+
+esp_err_t i2c_param_config(i2c_port_t i2c_num, const i2c_config_t *config)
+{
+    if (i2c_num < 0 || i2c_num >= I2C_NUM_MAX || config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (config->mode == I2C_MODE_MASTER && config->master.clk_speed != 0) {
+        ports[i2c_num].clk_speed = config->master.clk_speed;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_driver_install(i2c_port_t i2c_num, i2c_mode_t mode, size_t slv_rx_buf_len, size_t slv_tx_buf_len, int intr_alloc_flags)
+{
+    if (i2c_num < 0 || i2c_num >= I2C_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ports[i2c_num].installed = true;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_driver_delete(i2c_port_t i2c_num)
+{
+    if (i2c_num < 0 || i2c_num >= I2C_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ports[i2c_num].installed = false;
+
+    return ESP_OK;
+}
+
+i2c_cmd_handle_t i2c_cmd_link_create(void)
+{
+    host_i2c_link_t *link = (host_i2c_link_t *) calloc(1, sizeof(host_i2c_link_t));
+
+    __atomic_add_fetch(&link_allocs, 1, __ATOMIC_RELAXED);
+
+    return (i2c_cmd_handle_t) link;
+}
+
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t *buffer, uint32_t size)
+{
+    if (buffer == NULL || size < 2 * I2C_INTERNAL_STRUCT_SIZE) {
+        return NULL;
+    }
+
+    host_i2c_link_t *link = (host_i2c_link_t *) buffer;
+
+    link->ops       = (host_i2c_op_t *) (buffer + 2 * I2C_INTERNAL_STRUCT_SIZE);
+    link->count     = 0;
+    link->capacity  = (size - 2 * I2C_INTERNAL_STRUCT_SIZE) / sizeof(host_i2c_op_t);
+    link->is_static = true;
+
+    return (i2c_cmd_handle_t) link;
+}
+
+void i2c_cmd_link_delete(i2c_cmd_handle_t cmd)
+{
+    host_i2c_link_t *link = (host_i2c_link_t *) cmd;
+
+    if (link != NULL && !link->is_static) {
+        free(link->ops);
+        free(link);
+    }
+}
+
+void i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd)
+{
+    /* Storage belongs to the caller */
+}
+
+static esp_err_t host_i2c_append(i2c_cmd_handle_t cmd, host_i2c_op_type_t type, uint8_t byte, const uint8_t *data, size_t len)
+{
+    host_i2c_link_t *link = (host_i2c_link_t *) cmd;
+
+    if (link == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (link->count == link->capacity) {
+        if (link->is_static) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        size_t capacity = link->capacity == 0 ? 16 : link->capacity * 2;
+        host_i2c_op_t *ops = (host_i2c_op_t *) realloc(link->ops, capacity * sizeof(host_i2c_op_t));
+
+        if (ops == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+
+        __atomic_add_fetch(&link_allocs, 1, __ATOMIC_RELAXED);
+
+        link->ops = ops;
+        link->capacity = capacity;
+    }
+
+    host_i2c_op_t *op = &link->ops[link->count++];
+
+    op->type = type;
+    op->byte = byte;
+    op->data = data;
+    op->len  = len;
+
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd)
+{
+    return host_i2c_append(cmd, host_i2c_op_start, 0, NULL, 0);
+}
+
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd, uint8_t data, bool ack_en)
+{
+    return host_i2c_append(cmd, host_i2c_op_byte, data, NULL, 1);
+}
+
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd, const uint8_t *data, size_t data_len, bool ack_en)
+{
+    if (data == NULL && data_len != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return host_i2c_append(cmd, host_i2c_op_data, 0, data, data_len);
+}
+
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd)
+{
+    return host_i2c_append(cmd, host_i2c_op_stop, 0, NULL, 0);
+}
+
+static void host_i2c_put(host_i2c_port_t *port, const uint8_t *data, size_t len)
+{
+    if (port->len + len > port->size) {
+        size_t size = port->size == 0 ? 256 : port->size;
+
+        while (size < port->len + len) {
+            size *= 2;
+        }
+
+        port->buf = (uint8_t *) realloc(port->buf, size);
+        port->size = size;
+    }
+
+    memcpy(port->buf + port->len, data, len);
+    port->len += len;
+}
+
+/* Deliver the assembled transaction to the attached device */
+static void host_i2c_end_transaction(host_i2c_port_t *port)
+{
+    port->stats.transactions++;
+    port->stats.bytes += port->len;
+    port->stats.bus_time_ns += ((uint64_t) (9 * port->len + 2) * 1000000000ULL) / port->clk_speed;
+
+    if (port->device != NULL && port->len != 0) {
+        port->device(port->ctx, port->buf, port->len);
+    }
+
+    port->len = 0;
+}
+
+esp_err_t i2c_master_cmd_begin(i2c_port_t i2c_num, i2c_cmd_handle_t cmd, TickType_t ticks_to_wait)
+{
+    if (i2c_num < 0 || i2c_num >= I2C_NUM_MAX || cmd == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_i2c_port_t *port = &ports[i2c_num];
+    host_i2c_link_t *link = (host_i2c_link_t *) cmd;
+
+    if (!port->installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    pthread_mutex_lock(&port->mutex);
+
+    port->stats.cmd_begins++;
+
+    bool started = false;
+
+    for (size_t index = 0; index < link->count; ++index) {
+        host_i2c_op_t *op = &link->ops[index];
+
+        switch (op->type) {
+            case host_i2c_op_start:
+                if (started) {
+                    /* Repeated START ends the previous transaction */
+                    host_i2c_end_transaction(port);
+                }
+                started = true;
+                break;
+
+            case host_i2c_op_stop:
+                if (started) {
+                    host_i2c_end_transaction(port);
+                }
+                started = false;
+                break;
+
+            case host_i2c_op_byte:
+                host_i2c_put(port, &op->byte, 1);
+                break;
+
+            case host_i2c_op_data:
+                host_i2c_put(port, op->data, op->len);
+                break;
+        }
+    }
+
+    if (started) {
+        /* Missing STOP; the real driver would time out */
+        port->len = 0;
+    }
+
+    pthread_mutex_unlock(&port->mutex);
+
+    return started ? ESP_ERR_TIMEOUT : ESP_OK;
+}
+
+void host_i2c_attach(int i2c_num, host_i2c_device_t device, void *ctx)
+{
+    host_i2c_port_t *port = &ports[i2c_num];
+
+    pthread_mutex_lock(&port->mutex);
+    port->device = device;
+    port->ctx = ctx;
+    pthread_mutex_unlock(&port->mutex);
+}
+
+void host_i2c_get_stats(int i2c_num, host_i2c_stats_t *stats)
+{
+    host_i2c_port_t *port = &ports[i2c_num];
+
+    pthread_mutex_lock(&port->mutex);
+    *stats = port->stats;
+    pthread_mutex_unlock(&port->mutex);
+
+    stats->link_allocs = __atomic_load_n(&link_allocs, __ATOMIC_RELAXED);
+}
+
+void host_i2c_reset_stats(int i2c_num)
+{
+    host_i2c_port_t *port = &ports[i2c_num];
+
+    pthread_mutex_lock(&port->mutex);
+    memset(&port->stats, 0, sizeof(port->stats));
+    pthread_mutex_unlock(&port->mutex);
+
+    __atomic_store_n(&link_allocs, 0, __ATOMIC_RELAXED);
+}
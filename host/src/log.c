@@ -0,0 +1,40 @@
+/*
+ * log.c
+ *
+ * Host shim: ESP_LOGx output and the microsecond timer.
+ */
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+esp_log_level_t host_log_level = ESP_LOG_WARN;
+
+void host_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    static const char letters[] = "NEWIDV";
+
+    if (level <= host_log_level) {
+        va_list args;
+
+        fprintf(stderr, "%c (%lld) %s: ", letters[level], (long long) (esp_timer_get_time() / 1000), tag);
+
+        va_start(args, format);
+        vfprintf(stderr, format, args);
+        va_end(args);
+
+        fputc('\n', stderr);
+    }
+}
+
+/* Microseconds of the monotonic clock, which like esp_timer counts from boot */
+int64_t esp_timer_get_time(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (int64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
@@ -0,0 +1,371 @@
+/*
+ * ssd1306_emu.c
+ *
+ * Software model of the SSD1306 command set and GDDRAM for the host build.
+ */
+#include <string.h>
+
+#include "ssd1306_emu.h"
+#include "host_i2c.h"
+
+/* Horizontal scroll step interval in frames, indexed by the 3-bit setting */
+static const uint16_t scroll_intervals[8] = { 5, 64, 128, 256, 3, 4, 25, 2 };
+
+void ssd1306_emu_init(ssd1306_emu_t *emu, uint8_t address, int width, int height)
+{
+    memset(emu, 0, sizeof(*emu));
+
+    emu->address        = address;
+    emu->width          = width;
+    emu->height         = height;
+
+    /* GDDRAM content is undefined at power on */
+    memset(emu->gddram, 0xA5, sizeof(emu->gddram));
+
+    emu->addr_mode      = 0x02;     /* Page addressing */
+    emu->column_end     = SSD1306_EMU_COLUMNS - 1;
+    emu->page_end       = SSD1306_EMU_PAGES - 1;
+    emu->mux_ratio      = SSD1306_EMU_ROWS - 1;
+    emu->contrast       = 0x7F;
+    emu->scroll_rows    = SSD1306_EMU_ROWS;
+    emu->scroll_interval = scroll_intervals[0];
+}
+
+void ssd1306_emu_attach(ssd1306_emu_t *emu, int i2c_num)
+{
+    host_i2c_attach(i2c_num, ssd1306_emu_transaction, emu);
+}
+
+/* Number of argument bytes following an opcode */
+static int ssd1306_emu_args(uint8_t op)
+{
+    switch (op) {
+        case 0x20: case 0x81: case 0x8D: case 0xA8:
+        case 0xD3: case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+            return 1;
+
+        case 0x21: case 0x22: case 0xA3:
+            return 2;
+
+        case 0x29: case 0x2A:
+            return 5;
+
+        case 0x26: case 0x27:
+            return 6;
+
+        default:
+            return 0;
+    }
+}
+
+static void ssd1306_emu_execute(ssd1306_emu_t *emu)
+{
+    uint8_t op = emu->command[0];
+    uint8_t *arg = &emu->command[1];
+
+    if (op <= 0x0F) {
+        emu->page_mode_column = (emu->page_mode_column & 0xF0) | (op & 0x0F);
+        emu->column = emu->page_mode_column;
+    } else if (op <= 0x1F) {
+        emu->page_mode_column = (emu->page_mode_column & 0x0F) | ((op & 0x07) << 4);
+        emu->column = emu->page_mode_column;
+    } else if (op >= 0x40 && op <= 0x7F) {
+        emu->start_line = op & 0x3F;
+    } else if (op >= 0xB0 && op <= 0xB7) {
+        emu->page = op & 0x07;
+    } else {
+        switch (op) {
+            case 0x20:
+                if ((arg[0] & 0x03) != 0x03) {
+                    emu->addr_mode = arg[0] & 0x03;
+                }
+                break;
+
+            case 0x21:
+                emu->column_start = arg[0] & 0x7F;
+                emu->column_end = arg[1] & 0x7F;
+                emu->column = emu->column_start;
+                break;
+
+            case 0x22:
+                emu->page_start = arg[0] & 0x07;
+                emu->page_end = arg[1] & 0x07;
+                emu->page = emu->page_start;
+                break;
+
+            case 0x26:
+            case 0x27:
+                emu->scroll_setup = op;
+                emu->scroll_start_page = arg[1] & 0x07;
+                emu->scroll_interval = scroll_intervals[arg[2] & 0x07];
+                emu->scroll_end_page = arg[3] & 0x07;
+                emu->scroll_vertical = 0;
+                break;
+
+            case 0x29:
+            case 0x2A:
+                emu->scroll_setup = op;
+                emu->scroll_start_page = arg[1] & 0x07;
+                emu->scroll_interval = scroll_intervals[arg[2] & 0x07];
+                emu->scroll_end_page = arg[3] & 0x07;
+                emu->scroll_vertical = arg[4] & 0x3F;
+                break;
+
+            case 0x2E:
+                emu->scroll_active = false;
+                break;
+
+            case 0x2F:
+                emu->scroll_active = true;
+                emu->scroll_frames = 0;
+                break;
+
+            case 0x81:
+                emu->contrast = arg[0];
+                break;
+
+            case 0xA0:
+            case 0xA1:
+                emu->segment_remap = op == 0xA1;
+                break;
+
+            case 0xA3:
+                emu->scroll_fixed_rows = arg[0] & 0x3F;
+                emu->scroll_rows = arg[1] & 0x7F;
+                emu->scroll_position = 0;
+                break;
+
+            case 0xA4:
+            case 0xA5:
+                emu->entire_on = op == 0xA5;
+                break;
+
+            case 0xA6:
+            case 0xA7:
+                emu->inverted = op == 0xA7;
+                break;
+
+            case 0xA8:
+                if ((arg[0] & 0x3F) >= 15) {
+                    emu->mux_ratio = arg[0] & 0x3F;
+                }
+                break;
+
+            case 0xAE:
+            case 0xAF:
+                emu->display_on = op == 0xAF;
+                break;
+
+            case 0xC0:
+            case 0xC8:
+                emu->com_remap = op == 0xC8;
+                break;
+
+            case 0xD3:
+                emu->display_offset = arg[0] & 0x3F;
+                break;
+
+            case 0x8D:
+            case 0xD5:
+            case 0xD9:
+            case 0xDA:
+            case 0xDB:
+            case 0xE3:
+                /* Analog and timing settings do not affect the image */
+                break;
+
+            default:
+                emu->stats.errors++;
+                break;
+        }
+    }
+}
+
+static void ssd1306_emu_command(ssd1306_emu_t *emu, uint8_t byte)
+{
+    emu->stats.command_bytes++;
+
+    if (emu->command_len == 0) {
+        emu->command_args = ssd1306_emu_args(byte);
+    }
+
+    emu->command[emu->command_len++] = byte;
+
+    if (emu->command_len > emu->command_args) {
+        ssd1306_emu_execute(emu);
+        emu->command_len = 0;
+    }
+}
+
+static void ssd1306_emu_data(ssd1306_emu_t *emu, uint8_t byte)
+{
+    emu->stats.data_bytes++;
+
+    emu->gddram[emu->page][emu->column] = byte;
+
+    switch (emu->addr_mode) {
+        case 0x00:
+            /* Horizontal: column first, then page, wrapping inside the window */
+            if (emu->column >= emu->column_end) {
+                emu->column = emu->column_start;
+                emu->page = emu->page >= emu->page_end ? emu->page_start : emu->page + 1;
+            } else {
+                emu->column++;
+            }
+            break;
+
+        case 0x01:
+            /* Vertical: page first, then column */
+            if (emu->page >= emu->page_end) {
+                emu->page = emu->page_start;
+                emu->column = emu->column >= emu->column_end ? emu->column_start : emu->column + 1;
+            } else {
+                emu->page++;
+            }
+            break;
+
+        default:
+            /* Page: column wraps within the page */
+            emu->column = emu->column >= SSD1306_EMU_COLUMNS - 1 ? emu->page_mode_column : emu->column + 1;
+            break;
+    }
+}
+
+void ssd1306_emu_transaction(void *ctx, const uint8_t *data, size_t len)
+{
+    ssd1306_emu_t *emu = (ssd1306_emu_t *) ctx;
+
+    if (len == 0 || (data[0] >> 1) != emu->address) {
+        return;
+    }
+
+    emu->stats.transactions++;
+    emu->stats.bytes += len;
+
+    if (data[0] & 0x01) {
+        /* Reads are not supported over I2C */
+        emu->stats.errors++;
+        return;
+    }
+
+    size_t index = 1;
+
+    while (index < len) {
+        uint8_t control = data[index++];
+
+        bool is_data = (control & 0x40) != 0;
+        bool single = (control & 0x80) != 0;
+
+        if ((control & 0x3F) != 0) {
+            emu->stats.errors++;
+        }
+
+        size_t end = single ? index + 1 : len;
+
+        if (end > len) {
+            /* Control byte promised a byte that never came */
+            emu->stats.errors++;
+            end = len;
+        }
+
+        for (; index < end; ++index) {
+            if (is_data) {
+                ssd1306_emu_data(emu, data[index]);
+            } else {
+                ssd1306_emu_command(emu, data[index]);
+            }
+        }
+    }
+}
+
+/* One scroll step: rotate the selected pages by a column and move the vertical offset */
+static void ssd1306_emu_scroll_step(ssd1306_emu_t *emu)
+{
+    bool left = emu->scroll_setup == 0x27 || emu->scroll_setup == 0x2A;
+
+    for (int page = emu->scroll_start_page; page <= emu->scroll_end_page; ++page) {
+        uint8_t *row = emu->gddram[page];
+
+        if (left) {
+            uint8_t first = row[0];
+            memmove(row, row + 1, SSD1306_EMU_COLUMNS - 1);
+            row[SSD1306_EMU_COLUMNS - 1] = first;
+        } else {
+            uint8_t last = row[SSD1306_EMU_COLUMNS - 1];
+            memmove(row + 1, row, SSD1306_EMU_COLUMNS - 1);
+            row[0] = last;
+        }
+    }
+
+    if (emu->scroll_vertical != 0 && emu->scroll_rows != 0) {
+        emu->scroll_position = (emu->scroll_position + emu->scroll_vertical) % emu->scroll_rows;
+    }
+}
+
+void ssd1306_emu_tick(ssd1306_emu_t *emu, uint32_t frames)
+{
+    if (!emu->scroll_active) {
+        return;
+    }
+
+    emu->scroll_frames += frames;
+
+    while (emu->scroll_frames >= emu->scroll_interval) {
+        emu->scroll_frames -= emu->scroll_interval;
+        ssd1306_emu_scroll_step(emu);
+    }
+}
+
+bool ssd1306_emu_pixel(const ssd1306_emu_t *emu, int x, int y)
+{
+    if (!emu->display_on || x < 0 || x >= emu->width || y < 0 || y >= emu->height || y > emu->mux_ratio) {
+        return false;
+    }
+
+    if (emu->entire_on) {
+        return true;
+    }
+
+    int column = emu->segment_remap ? x : SSD1306_EMU_COLUMNS - 1 - x;
+    int row = emu->com_remap ? y : emu->mux_ratio - y;
+
+    row = (row + emu->display_offset) % SSD1306_EMU_ROWS;
+
+    /* Rows in the vertical scroll area move with the scroll position */
+    if (emu->scroll_rows != 0 && row >= emu->scroll_fixed_rows && row < emu->scroll_fixed_rows + emu->scroll_rows) {
+        row = emu->scroll_fixed_rows + (row - emu->scroll_fixed_rows + emu->scroll_position) % emu->scroll_rows;
+    }
+
+    row = (row + emu->start_line) % SSD1306_EMU_ROWS;
+
+    bool set = (emu->gddram[row / 8][column] >> (row % 8)) & 1;
+
+    return set != emu->inverted;
+}
+
+int ssd1306_emu_write_pbm(const ssd1306_emu_t *emu, FILE *fp)
+{
+    if (fprintf(fp, "P1\n%d %d\n", emu->width, emu->height) < 0) {
+        return -1;
+    }
+
+    for (int y = 0; y < emu->height; ++y) {
+        for (int x = 0; x < emu->width; ++x) {
+            fputc(ssd1306_emu_pixel(emu, x, y) ? '1' : '0', fp);
+        }
+        fputc('\n', fp);
+    }
+
+    return ferror(fp) ? -1 : 0;
+}
+
+bool ssd1306_emu_matches(const ssd1306_emu_t *emu, const uint8_t *frame_buf, int width, int height)
+{
+    for (int page = 0; page < height / 8; ++page) {
+        if (memcmp(emu->gddram[page], &frame_buf[page * width], width) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
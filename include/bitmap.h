@@ -6,10 +6,31 @@
 #ifndef __bitmap_h_included
 #define __bitmap_h_included
 
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * How bits are stored.  Raw bits are page-major: each 8-row band of the image
+ * as width bytes, bit 0 the top row.  The compressed formats hold that same
+ * byte sequence and are decoded as they are drawn:
+ *
+ *   rle    packets: a byte n below 0x80 is followed by n + 1 literal bytes;
+ *          a byte n from 0x80 up is followed by one byte repeated n - 0x7E times
+ *   lz     groups of a flag byte, then up to eight items taken low flag bit
+ *          first: a clear bit is one literal byte, a set bit a match of two
+ *          bytes, distance - 1 and length - 3, copied from the last 256 bytes
+ */
+typedef enum {
+    bitmap_format_raw,
+    bitmap_format_rle,
+    bitmap_format_lz,
+} bitmap_format_t;
+
 typedef struct {
     int     width;
     int     height;
     uint8_t *bits;
+    bitmap_format_t format;
 } bitmap_t;
 
 /* Blending method for bitmap images */
@@ -19,5 +40,25 @@ typedef enum {
     bitmap_method_NAND,
 } bitmap_method_t;
 
-#endif /* __bitmap_h_included */
+/* Streaming decoder for compressed bits */
+typedef struct {
+    const uint8_t   *src;
+    bitmap_format_t format;
+    int             left;               /* Bytes left in the current packet or match */
+    bool            repeat;             /* rle: the packet repeats one byte */
+    uint8_t         flags;              /* lz: item flags not used yet */
+    uint8_t         flag_count;
+    uint8_t         head;               /* lz: next window slot */
+    uint16_t        distance;           /* lz: of the current match */
+    uint8_t         window[256];
+} bitmap_decoder_t;
+
+void bitmap_decoder_init(bitmap_decoder_t *decoder, const bitmap_t *bitmap);
+
+/*
+ * Next decoded bytes, at most max of them.  Returns the count and points *span
+ * at them; for a run (*run set) *span is the single repeated byte.
+ */
+int bitmap_decoder_next(bitmap_decoder_t *decoder, int max, const uint8_t **span, bool *run);
 
+#endif /* __bitmap_h_included */
@@ -10,6 +10,8 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
 #include "font.h"
 #include "bitmap.h"
 
@@ -21,15 +23,272 @@ typedef enum {
 
 typedef struct __display__ display_t;
 
+/* Hardware scroll directions; the up variants also move the image vertically */
+typedef enum {
+    display_scroll_right,
+    display_scroll_left,
+    display_scroll_up_right,
+    display_scroll_up_left,
+} display_scroll_t;
+
+/* Operations in a draw list */
+typedef enum {
+    display_op_clear,
+    display_op_text,
+    display_op_bitmap,
+    display_op_rectangle,
+    display_op_line,
+    display_op_pixel,
+    display_op_progress_bar,
+} display_op_type_t;
+
+/* One draw list entry: x, y as for the matching draw_ call (the first end point of a line) */
+typedef struct {
+    display_op_type_t  type;
+    int                x;
+    int                y;
+    union {
+        struct {
+            const char         *text;
+        } text;
+        struct {
+            bitmap_t           *bitmap;
+            int                width;
+            int                height;
+            bitmap_method_t    method;
+        } bitmap;
+        struct {
+            int                width;
+            int                height;
+            draw_flags_t       flags;
+        } rectangle;
+        struct {
+            int                x2;
+            int                y2;
+            bool               set;
+        } line;
+        struct {
+            bool               set;
+        } pixel;
+        struct {
+            int                width;
+            int                height;
+            int                range;
+            int                value;
+            const char         *text;
+        } progress_bar;
+    };
+} display_op_t;
+
+#define DISPLAY_OP_CLEAR()                      { .type = display_op_clear }
+#define DISPLAY_OP_TEXT(x_, y_, text_)          { .type = display_op_text, .x = (x_), .y = (y_), .text = { (text_) } }
+#define DISPLAY_OP_BITMAP(x_, y_, bitmap_, width_, height_, method_) \
+            { .type = display_op_bitmap, .x = (x_), .y = (y_), .bitmap = { (bitmap_), (width_), (height_), (method_) } }
+#define DISPLAY_OP_RECTANGLE(x_, y_, width_, height_, flags_) \
+            { .type = display_op_rectangle, .x = (x_), .y = (y_), .rectangle = { (width_), (height_), (flags_) } }
+#define DISPLAY_OP_LINE(x1_, y1_, x2_, y2_, set_) \
+            { .type = display_op_line, .x = (x1_), .y = (y1_), .line = { (x2_), (y2_), (set_) } }
+#define DISPLAY_OP_PIXEL(x_, y_, set_)          { .type = display_op_pixel, .x = (x_), .y = (y_), .pixel = { (set_) } }
+#define DISPLAY_OP_PROGRESS_BAR(x_, y_, width_, height_, range_, value_, text_) \
+            { .type = display_op_progress_bar, .x = (x_), .y = (y_), .progress_bar = { (width_), (height_), (range_), (value_), (text_) } }
+
+#if CONFIG_DISPLAY_RENDER_QUEUE
+/* A queued draw command; text is copied in so the submitter's string may go away */
+typedef struct {
+    uint32_t           sequence;        /* Slot state, advanced by submitter and render task */
+    uint32_t           queued;          /* esp_timer_get_time() at submit, in microseconds */
+    display_op_t       op;
+    char               text[CONFIG_DISPLAY_RENDER_TEXT_LENGTH];
+} display_render_cell_t;
+
+/* Render queue statistics */
+typedef struct {
+    uint32_t           submitted;       /* Commands accepted by submit() */
+    uint32_t           dropped;         /* Commands refused because the queue was full */
+    uint32_t           rendered;        /* Commands drawn by the render task */
+    uint32_t           batches;         /* Drains, each ending in one show() */
+    uint32_t           depth;           /* Commands waiting now */
+    uint32_t           max_depth;       /* Most commands ever waiting */
+    uint32_t           latency_avg_us;  /* Submit to show(), averaged over rendered commands */
+    uint32_t           latency_max_us;
+} display_render_stats_t;
+#endif
+
+/* Longest text draw_textf formats, including the terminator */
+#define DISPLAY_TEXTF_LENGTH            64
+
+#define DISPLAY_TEXT_FIELD_LENGTH       24
+
+/* One line of text at a fixed place, redrawn through draw_field; set up with DISPLAY_TEXT_FIELD_INIT */
+typedef struct {
+    int                x;
+    int                y;
+    int                width;           /* Glyphs that would cross it are not drawn */
+    int                height;          /* Font height when first drawn */
+    const font_t       *font;           /* Font of the last draw; NULL before the first */
+    char               text[DISPLAY_TEXT_FIELD_LENGTH];     /* As last drawn */
+} display_text_field_t;
+
+#define DISPLAY_TEXT_FIELD_INIT(x_, y_, width_) \
+            { .x = (x_), .y = (y_), .width = (width_) }
+
+#define DISPLAY_TEXT_LAYOUT_LENGTH      128
+#define DISPLAY_TEXT_LAYOUT_LINES       8
+
+/* Horizontal alignment, for text layouts and widget labels */
+typedef enum {
+    display_align_left,
+    display_align_center,
+    display_align_right,
+} display_align_t;
+
+/* One laid out line: bytes start .. start + length of the layout's text */
+typedef struct {
+    int                start;
+    int                length;
+    int                x;               /* Left edge, aligned */
+    int                width;           /* Including the ellipsis */
+    bool               ellipsis;        /* Text was cut here; an ellipsis follows */
+} display_text_line_t;
+
+/*
+ * Text wrapped at word boundaries into a box, laid out once by
+ * display_layout_text and drawn as often as needed through draw_layout; set up
+ * with DISPLAY_TEXT_LAYOUT_INIT.  Lines are the layout font's height apart.
+ */
+typedef struct {
+    int                x;
+    int                y;
+    int                width;
+    int                height;
+    display_align_t    align;
+    const font_t       *font;           /* Font laid out for */
+    int                count;           /* Lines */
+    display_text_line_t lines[DISPLAY_TEXT_LAYOUT_LINES];
+    char               text[DISPLAY_TEXT_LAYOUT_LENGTH];   /* Copy of the text laid out */
+} display_text_layout_t;
+
+#define DISPLAY_TEXT_LAYOUT_INIT(x_, y_, width_, height_, align_) \
+            { .x = (x_), .y = (y_), .width = (width_), .height = (height_), .align = (align_) }
+
+/*
+ * Break UTF-8 text into the layout's box: at spaces, inside a word only when it
+ * is wider than the box, and always at '\n'.  Text that does not fit the lines
+ * of the box ends in an ellipsis.  Needs no display; nothing is drawn.
+ */
+void display_layout_text(display_text_layout_t *layout, const font_t *font, const char *text);
+
+#if CONFIG_DISPLAY_PROGRESS_BAR_ENABLED
+#define DISPLAY_PROGRESS_TEXT_LENGTH    16
+
+/* A progress bar updated in place through update_progress_bar; set up with DISPLAY_PROGRESS_BAR_INIT */
+typedef struct {
+    int                x;
+    int                y;
+    int                width;
+    int                height;
+    int                range;
+    int                filled;          /* Bar columns last drawn; -1 draws everything next time */
+    int                text_x;          /* Where the last text went */
+    int                text_y;
+    int                text_width;
+    int                text_height;
+    char               text[DISPLAY_PROGRESS_TEXT_LENGTH];
+} display_progress_bar_t;
+
+#define DISPLAY_PROGRESS_BAR_INIT(x_, y_, width_, height_, range_) \
+            { .x = (x_), .y = (y_), .width = (width_), .height = (height_), .range = (range_), .filled = -1 }
+#endif
+
+#if CONFIG_DISPLAY_GLYPH_CACHE
+/* A glyph split at a row offset into the bytes for its first and second page */
+typedef struct {
+    const font_t       *font;           /* NULL while the slot is empty */
+    int32_t            ch;
+    uint8_t            shift;           /* Rows below the page boundary */
+    uint8_t            width;
+    uint8_t            strips[2][CONFIG_DISPLAY_GLYPH_CACHE_WIDTH];
+} display_glyph_t;
+
+/* The cache is two-way set associative, and width must fit the uint8_t */
+_Static_assert(CONFIG_DISPLAY_GLYPH_CACHE_ENTRIES >= 2 && CONFIG_DISPLAY_GLYPH_CACHE_ENTRIES % 2 == 0,
+               "CONFIG_DISPLAY_GLYPH_CACHE_ENTRIES must be even and at least 2");
+_Static_assert(CONFIG_DISPLAY_GLYPH_CACHE_WIDTH >= 1 && CONFIG_DISPLAY_GLYPH_CACHE_WIDTH <= 255,
+               "CONFIG_DISPLAY_GLYPH_CACHE_WIDTH must be 1 to 255");
+#endif
+
+/* Range of columns in one page modified since the last transfer (clean when x1 > x2) */
+typedef struct {
+    int16_t            x1;
+    int16_t            x2;
+} display_dirty_t;
+
+/* Transfer statistics */
+typedef struct {
+    uint32_t           shows;           /* Frames requested through show() */
+    uint32_t           coalesced;       /* Requested frames superseded before they were flushed */
+    uint32_t           frames;          /* Transfers issued to the panel */
+    uint32_t           bytes_sent;      /* Bytes put on the bus (including addressing overhead) */
+    uint32_t           bytes_saved;     /* Bytes a full frame transfer would have needed in addition */
+#if CONFIG_DISPLAY_GLYPH_CACHE_STATS
+    uint32_t           glyph_hits;      /* Glyphs drawn from the glyph cache */
+    uint32_t           glyph_misses;    /* Glyphs the cache had to shift first */
+#endif
+} display_stats_t;
+
 typedef struct __display__ {
     void               *driver_info;
     SemaphoreHandle_t  mutex;
 
+    /* Storage belongs to the caller (display_create_static) */
+    bool               is_static;
+
     uint8_t            flags;
 
     uint8_t*           frame_buf;
     size_t             frame_len;
 
+    /* One dirty column range per page */
+    display_dirty_t*   dirty;
+    int                pages;
+
+    /* What _show transmits: frame_buf and dirty, or the flush copies when asynchronous */
+    uint8_t*           show_buf;
+    display_dirty_t*   show_dirty;
+
+    display_stats_t    stats;
+
+    /* GDDRAM row shown at the top of the panel, and the value _show transmits */
+    int                start_line;
+    int                show_start_line;
+
+#if CONFIG_DISPLAY_SCROLL_ENABLED
+    bool               scrolling;       /* A hardware scroll runs; show() sends nothing */
+#endif
+
+#if CONFIG_DISPLAY_CONSOLE_ENABLED
+    bool               console;
+    int                console_lines;   /* Lines written since the console was enabled, up to pages */
+#endif
+
+#if CONFIG_DISPLAY_ASYNC_FLUSH
+    TaskHandle_t       flush_task;
+    EventGroupHandle_t flush_events;
+    uint32_t           flushed;         /* Value of stats.shows last flushed */
+    bool               flush_exit;
+#endif
+
+#if CONFIG_DISPLAY_RENDER_QUEUE
+    TaskHandle_t       render_task;
+    EventGroupHandle_t render_events;
+    display_render_cell_t *render_cells;
+    uint32_t           render_head;     /* Next slot a submitter claims */
+    uint32_t           render_tail;     /* Next slot the render task draws */
+    bool               render_exit;
+    display_render_stats_t render_stats;    /* depth and latency_avg_us are filled by get_render_stats() */
+    uint64_t           render_latency_us;   /* Sum over rendered commands */
+#endif
+
     /* Overall size */
     int                width;
     int                height;
@@ -40,22 +299,52 @@ typedef struct __display__ {
     const font_t       *font;
     int                font_height;
 
+#if CONFIG_DISPLAY_GLYPH_CACHE
+    display_glyph_t    glyph_cache[CONFIG_DISPLAY_GLYPH_CACHE_ENTRIES];
+#endif
+
     /* Private - not meant for user calls */
     void               (*_lock)(display_t *display);
     void               (*_unlock)(display_t *display);
     void               (*_show)(display_t *display);
+    void               (*_mark_dirty)(display_t *display, int x, int y, int width, int height);
 
     /* User entry points */
     void               (*close)(display_t *display);
     void               (*clear)(display_t *display);
     void               (*hold)(display_t *display);
     void               (*show)(display_t *display);
+    bool               (*wait_flushed)(display_t *display, TickType_t timeout);
     void               (*contrast)(display_t *display, int setting);
+    /* Text is UTF-8; characters the font lacks draw as its replacement glyph */
     void               (*draw_text)(display_t *display, int x, int y, const char* text);
+    void               (*draw_textf)(display_t *display, int x, int y, const char *format, ...) __attribute__((format(printf, 4, 5)));
+    /* Format into a field, redrawing only the glyphs that changed */
+    void               (*draw_field)(display_t *display, display_text_field_t *field, const char *format, ...) __attribute__((format(printf, 3, 4)));
+    /* Clear a layout's box and draw its lines */
+    void               (*draw_layout)(display_t *display, const display_text_layout_t *layout);
     void               (*enable)(display_t *display, bool enable);
+#if CONFIG_DISPLAY_SCROLL_ENABLED
+    /* Scroll pages page1..page2 in the panel, a column every 'frames' refreshes,
+     * raising the image 'offset' rows per step for the up directions.  Drawing
+     * goes on in the frame buffer only: nothing reaches the panel until
+     * stop_scroll, which sends the whole frame again. */
+    void               (*start_scroll)(display_t *display, display_scroll_t direction, int page1, int page2, int frames, int offset);
+    void               (*stop_scroll)(display_t *display);
+#endif
     void               (*set_font)(display_t *display, const font_t *font);
     const font_t*      (*get_font)(display_t *display);
     void               (*draw_bitmap)(display_t *display, bitmap_t* bitmap, int x, int y, int width, int height, bitmap_method_t method);
+    void               (*draw_list)(display_t *display, const display_op_t *ops, int count);
+#if CONFIG_DISPLAY_RENDER_QUEUE
+    /* Queue a command for the render task without taking the display lock.  Returns
+     * false if the queue is full.  Bitmaps must stay valid until drawn.  Draws at
+     * once when the display was created without DISPLAY_FLAGS_RENDER. */
+    bool               (*submit)(display_t *display, const display_op_t *op);
+    /* Wait until everything submitted so far has been drawn and shown */
+    bool               (*wait_rendered)(display_t *display, TickType_t timeout);
+    void               (*get_render_stats)(display_t *display, display_render_stats_t *stats);
+#endif
 #if CONFIG_DISPLAY_RECTANGLE_ENABLED
     void               (*draw_rectangle)(display_t *display, int x, int y, int width, int height, draw_flags_t flags);
 #endif
@@ -65,15 +354,70 @@ typedef struct __display__ {
 #if CONFIG_DISPLAY_PIXEL_ENABLED
     void               (*draw_pixel)(display_t *display, int x, int y, bool set);
 #endif
+#if CONFIG_DISPLAY_CONSOLE_ENABLED
+    /* Console mode: each text line takes a page and older lines scroll up.  On
+     * 64 row panels scrolling moves the panel's start line, so frame buffer rows
+     * no longer match screen rows: while the console is enabled, write to the
+     * screen through console_write only, not draw_text, fields, widgets or the
+     * other primitives.  Enabling or disabling clears the screen. */
+    void               (*console_enable)(display_t *display, bool enable);
+    void               (*console_write)(display_t *display, const char *text);
+#endif
 #if CONFIG_DISPLAY_PROGRESS_BAR_ENABLED
     void               (*draw_progress_bar)(display_t *display, int x, int y, int width, int height, int total, int progress, const char* text);
+    /* Redraw only what moved since the bar's last update; text wider than the
+     * bar spills past its edges until the next update erases it */
+    void               (*update_progress_bar)(display_t *display, display_progress_bar_t *bar, int progress, const char *text);
 #endif
 } display_t;
 
 #define DISPLAY_FLAGS_MIRROR_X  0x01
 #define DISPLAY_FLAGS_MIRROR_Y  0x02
+#define DISPLAY_FLAGS_ASYNC     0x04    /* Flush from a background task (CONFIG_DISPLAY_ASYNC_FLUSH) */
+#define DISPLAY_FLAGS_RENDER    0x08    /* Draw submitted commands in a render task (CONFIG_DISPLAY_RENDER_QUEUE) */
 #define DISPLAY_FLAGS_DEFAULT   0x00
 
+#define DISPLAY_PAGES(height)               (((height) + 7) / 8)
+#define DISPLAY_FRAME_LEN(width, height)    ((width) * DISPLAY_PAGES(height))
+
+/* Round a static buffer piece up so the next one stays pointer aligned */
+#define DISPLAY_STATIC_ALIGN(size)          (((size) + sizeof(void*) - 1) & ~(sizeof(void*) - 1))
+
+#if CONFIG_DISPLAY_ASYNC_FLUSH
+#define DISPLAY_STATIC_COPIES               2   /* drawing and show buffers */
+#else
+#define DISPLAY_STATIC_COPIES               1
+#endif
+
+/* Bytes of buffer display_create_static needs for a panel */
+#define DISPLAY_STATIC_BUFFER_SIZE(width, height) \
+            (sizeof(void*) + DISPLAY_STATIC_COPIES * (DISPLAY_STATIC_ALIGN(DISPLAY_FRAME_LEN(width, height)) + \
+                                                      DISPLAY_STATIC_ALIGN(DISPLAY_PAGES(height) * sizeof(display_dirty_t))))
+
+/* Caller-owned objects for display_create_static */
+typedef struct {
+    display_t          display;
+    StaticSemaphore_t  mutex;
+#if CONFIG_DISPLAY_ASYNC_FLUSH
+    StaticEventGroup_t flush_events;
+    StaticTask_t       flush_task;
+    StackType_t        flush_stack[CONFIG_DISPLAY_FLUSH_TASK_STACK];
+#endif
+#if CONFIG_DISPLAY_RENDER_QUEUE
+    StaticEventGroup_t render_events;
+    StaticTask_t       render_task;
+    StackType_t        render_stack[CONFIG_DISPLAY_RENDER_TASK_STACK];
+    display_render_cell_t render_cells[CONFIG_DISPLAY_RENDER_QUEUE_LENGTH];
+#endif
+} display_static_t;
+
 display_t *display_create(int width, int height, uint8_t flags);
 
+/*
+ * Build a display entirely in caller storage: the objects in *storage and the
+ * buffers carved from buffer, which must hold DISPLAY_STATIC_BUFFER_SIZE bytes.
+ * Returns NULL if it is too small.  close() releases nothing the caller owns.
+ */
+display_t *display_create_static(display_static_t *storage, void *buffer, size_t size, int width, int height, uint8_t flags);
+
 #endif /* __SSD1336_h_included */
@@ -0,0 +1,60 @@
+/*
+ * display_trace.h
+ *
+ * Optional diagnostics for the drawing and transfer paths.
+ *
+ * CONFIG_DISPLAY_DEBUG_LOG keeps the formatted ESP_LOGI calls in the hot paths;
+ * without it they compile to nothing.  CONFIG_DISPLAY_TRACE records each call
+ * as a small binary entry (op, arguments, timestamp) in a fixed-size ring that
+ * can be read back or dumped on demand.
+ */
+#ifndef __display_trace_h_included
+#define __display_trace_h_included
+
+#include <stdint.h>
+
+#include "esp_log.h"
+
+typedef enum {
+    display_trace_op_clear,
+    display_trace_op_show,          /* args: shows, hold_count */
+    display_trace_op_flush,         /* args: windows, bytes */
+    display_trace_op_draw_text,     /* args: x, y, length */
+    display_trace_op_draw_bitmap,   /* args: x, y, width, height */
+    display_trace_op_draw_pixel,    /* args: x, y, set */
+    display_trace_op_draw_line,     /* args: x1, y1, x2, y2 */
+    display_trace_op_draw_rectangle,/* args: x, y, width, height */
+    display_trace_op_draw_progress, /* args: x, y, range, value */
+    display_trace_op_contrast,      /* args: setting */
+    display_trace_op_enable,        /* args: enable */
+    display_trace_op_scroll,        /* args: direction (-1 stop), page1, page2, frames */
+    display_trace_op_max,
+} display_trace_op_t;
+
+typedef struct {
+    uint32_t            timestamp;  /* esp_timer_get_time() in microseconds, wrapping */
+    uint8_t             op;         /* display_trace_op_t */
+    int16_t             args[4];
+} display_trace_entry_t;
+
+#if CONFIG_DISPLAY_DEBUG_LOG
+#define DISPLAY_LOGI(tag, format, ...)      ESP_LOGI(tag, format, ##__VA_ARGS__)
+#else
+#define DISPLAY_LOGI(tag, format, ...)      do { } while (0)
+#endif
+
+#if CONFIG_DISPLAY_TRACE
+#define DISPLAY_TRACE(op, a0, a1, a2, a3)   display_trace_record(op, a0, a1, a2, a3)
+
+void display_trace_record(display_trace_op_t op, int a0, int a1, int a2, int a3);
+
+/* Copy out up to max entries, oldest first; returns the number copied */
+int  display_trace_read(display_trace_entry_t *entries, int max);
+
+/* Print the ring, oldest first, and empty it */
+void display_trace_dump(void);
+#else
+#define DISPLAY_TRACE(op, a0, a1, a2, a3)   do { } while (0)
+#endif
+
+#endif /* __display_trace_h_included */
@@ -7,6 +7,8 @@
 #define __fonts_h_included
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
 #include <sys/types.h>
 #include "bitmap.h"
 
@@ -14,23 +16,72 @@ typedef enum {
     font_flag_pitch    = 0x01,
     font_flag_variable = font_flag_pitch,
     font_flag_fixed    = 0x00,
+    font_flag_sparse   = 0x02,      /* Characters map to glyphs through map_blocks and map */
 } font_flags_t;
+
+/* Sparse fonts map characters in blocks of this many */
+#define FONT_MAP_BLOCK          32
+#define FONT_MAP_NONE           0xFFFF  /* No glyph in a map row */
+
+/* Decoded in place of malformed UTF-8 */
+#define FONT_REPLACEMENT_CH     0xFFFD
+
+/* Where a variable pitch glyph's columns start in base, and how many there are */
+typedef struct {
+    uint16_t     offset;
+    uint8_t      width;
+} font_glyph_t;
      
+/*
+ * Glyphs are stored like bitmaps: page by page, one byte per column.  Fixed
+ * pitch glyphs follow each other at a stride of width times the pages; variable
+ * pitch glyphs are packed and found through the glyphs index.
+ *
+ * Compressed glyphs (format other than raw) are each a stream of their own,
+ * found through the glyphs index whatever the pitch.
+ *
+ * Glyphs are numbered from 0 in storage order.  A plain font holds one per
+ * character from first_ch to last_ch.  A sparse font goes through two levels
+ * instead: map_blocks has a byte per FONT_MAP_BLOCK characters from first_ch's
+ * block on, 0 when the block has no glyphs, else 1 + the map row giving each
+ * of its characters' glyph number.
+ */
 typedef struct {
     uint8_t      *base;
     font_flags_t flags;
     int          first_ch;
     int          last_ch;
     int          space_ch;
-    int          width;
+    int          width;                 /* Variable pitch: the widest glyph */
     int          height;
+    const font_glyph_t *glyphs;         /* Variable pitch or compressed: one per glyph */
+    const uint8_t      *map_blocks;     /* Sparse: map row + 1 per block, 0 if empty */
+    const uint16_t     (*map)[FONT_MAP_BLOCK];
+    int                replacement_ch;  /* Drawn for characters without a glyph; 0 for none */
+    bitmap_format_t    format;          /* Glyph storage */
 } font_t;
 
 /*
- * Return address of the row of font glyph bytes
+ * Return address of the row of font glyph bytes, or NULL when the font has no
+ * glyph for ch.  Width and height of the glyph go to pwidth and pheight when set.
  */
 uint8_t *font_char(const font_t *font, int ch, int *pwidth, int *pheight);
+
+/* Like font_char, but falls back to the font's replacement glyph */
 uint8_t *char_to_bitmap(bitmap_t *bitmap, const font_t *font, int ch);
+
+/*
+ * Decode the UTF-8 character at *ptext and step past it.  Malformed or cut off
+ * sequences give FONT_REPLACEMENT_CH; the terminating NUL is never stepped over.
+ */
+int text_next_char(const char **ptext);
+
+/*
+ * Drop a UTF-8 sequence cut off at the end of text, as a truncating snprintf
+ * into a fixed buffer leaves it, so the text does not end in a replacement glyph.
+ */
+void text_trim_utf8(char *text);
+
 void text_metrics(const font_t* font, const char* text, int *pwidth, int *pheight);
 
 #endif /* __fonts_h_included */
@@ -7,7 +7,7 @@
 
 #include "font.h"
 
-extern font_t font8x8_basic;
+extern const font_t font8x8_basic;
 
 #endif /* __font8x8_basic_h_included */
 
@@ -0,0 +1,12 @@
+/*
+ * font8x8_prop.h
+ */
+
+#ifndef __font8x8_prop_h_included
+#define __font8x8_prop_h_included
+
+#include "font.h"
+
+extern const font_t font8x8_prop;
+
+#endif /* __font8x8_prop_h_included */
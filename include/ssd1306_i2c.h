@@ -4,12 +4,38 @@
  * User access to the ssd1306 i2c driver.
  */
 #include "display.h"
+#include "ssd1306_i2c_internal.h"
 
 #ifndef __ssd1306_i2c_h_included
 #define __ssd1306_i2c_h_included
 
+/* Caller-owned objects for ssd1306_i2c_create_static */
+typedef struct {
+    display_static_t         display;
+    ssd1306_i2c_driver_info  driver_info;
+} ssd1306_i2c_static_t;
+
+/* Bytes of buffer ssd1306_i2c_create_static needs for a panel */
+#define SSD1306_I2C_STATIC_BUFFER_SIZE(width, height) \
+            (DISPLAY_STATIC_BUFFER_SIZE(width, height) + sizeof(void*) + \
+             DISPLAY_STATIC_ALIGN(SSD1306_MAX_WINDOWS(width, height) * sizeof(ssd1306_window_t)) + \
+             SSD1306_STATIC_LINK_SIZE(width, height) + SSD1306_STATIC_SHADOW_SIZE(width, height))
+
 display_t *ssd1306_i2c_create(uint8_t flags);
-display_t *ssd1306_i2c_create_raw(int i2c_num, int scl_pin, int sda_pin, int reset_pin, int clk_speed, int width, int height, uint8_t flags);
+display_t *ssd1306_i2c_create_raw(int i2c_num, int sda_pin, int scl_pin, int reset_pin, int clk_speed, int width, int height, uint8_t flags);
+
+/*
+ * Like ssd1306_i2c_create_raw, but everything lives in caller storage, e.g.
+ *
+ *     static ssd1306_i2c_static_t oled;
+ *     static uint8_t oled_buffer[SSD1306_I2C_STATIC_BUFFER_SIZE(128, 64)];
+ *
+ *     display_t *display = ssd1306_i2c_create_static(&oled, oled_buffer, sizeof(oled_buffer), ...);
+ *
+ * Returns NULL if the buffer is too small.
+ */
+display_t *ssd1306_i2c_create_static(ssd1306_i2c_static_t *storage, void *buffer, size_t size,
+                                     int i2c_num, int sda_pin, int scl_pin, int reset_pin, int clk_speed, int width, int height, uint8_t flags);
 
 #endif /* __ssd1306_i2c_h_included */
 
@@ -25,6 +25,28 @@
 #define SSD1306_CMD_SET_COLUMN_RANGE       0x21    // Starting / ending column address for a region
 #define SSD1306_CMD_SET_PAGE_RANGE         0x22    // Starting / ending page address for a region
 
+// Bus bytes needed to address one update window: address, control and both
+// range commands for the command part plus address and control for the data part
+#define SSD1306_WINDOW_OVERHEAD            10
+
+// Cost of opening a window when planning updates: the overhead bytes plus
+// roughly one byte time for the two START conditions
+#define SSD1306_WINDOW_COST                (SSD1306_WINDOW_OVERHEAD + 1)
+
+// Command link operations per window besides its data rows: two STARTs, the
+// range command header and the data control header
+#define SSD1306_WINDOW_LINK_OPS            4
+
+// Command link operations for a start line change following a frame transfer
+#define SSD1306_START_LINE_LINK_OPS        2
+
+// Command link operations for a command transfer: START, address, control,
+// the command bytes and STOP
+#define SSD1306_COMMAND_LINK_OPS           5
+
+// Bytes of link storage for a number of operations, including the link header
+#define SSD1306_LINK_SIZE(ops)             ((2 + (ops)) * I2C_INTERNAL_STRUCT_SIZE)
+
 #define SSD1306_CMD_SET_
 // Fundamental commands (pg.28)
 #define SSD1306_CMD_SET_CONTRAST           0x81    // follow with 0x7F
@@ -52,15 +74,90 @@
 #define SSD1306_CMD_SET_PRECHARGE          0xD9    // follow with 0xF1
 #define SSD1306_CMD_SET_VCOMH_DESELECT     0xDB    // follow with 0x30
 
+// Scrolling Command Table (pg.28)
+#define SSD1306_CMD_SCROLL_RIGHT           0x26    // follow with 0x00, start page, interval, end page, 0x00, 0xFF
+#define SSD1306_CMD_SCROLL_LEFT            0x27
+#define SSD1306_CMD_SCROLL_UP_RIGHT        0x29    // follow with 0x00, start page, interval, end page, vertical offset
+#define SSD1306_CMD_SCROLL_UP_LEFT         0x2A
+#define SSD1306_CMD_SCROLL_STOP            0x2E    // GDDRAM must be rewritten afterwards
+#define SSD1306_CMD_SCROLL_START           0x2F
+#define SSD1306_CMD_SET_SCROLL_AREA        0xA3    // follow with fixed top rows, scrolled rows
+
 // Charge Pump (pg.62)
 #define SSD1306_CMD_SET_CHARGE_PUMP        0x8D    // follow with 0x14
 
-#include "ssd1306_i2c.h"
+#include "display.h"
+#include "driver/i2c.h"
+
+#if CONFIG_SSD1306_I2C_SHADOW_DIFF
+// Worst case plan: one window per run of changed bytes, separated by gaps of a window's cost
+#define SSD1306_MAX_WINDOWS(width, height) \
+            (DISPLAY_PAGES(height) * (((width) + SSD1306_WINDOW_COST) / (SSD1306_WINDOW_COST + 1) + 1))
+
+// Plans costing more than a full frame are replaced by one window, and each data
+// row of a window comes from a separate run
+#define SSD1306_SHOW_LINK_OPS(width, height) \
+            ((DISPLAY_FRAME_LEN(width, height) / SSD1306_WINDOW_COST + 1) * SSD1306_WINDOW_LINK_OPS + SSD1306_MAX_WINDOWS(width, height) + \
+             SSD1306_START_LINE_LINK_OPS + 1)
+#else
+// Worst case plan: every other page dirty
+#define SSD1306_MAX_WINDOWS(width, height) \
+            ((DISPLAY_PAGES(height) + 1) / 2)
+
+#define SSD1306_SHOW_LINK_OPS(width, height) \
+            (SSD1306_MAX_WINDOWS(width, height) * SSD1306_WINDOW_LINK_OPS + DISPLAY_PAGES(height) + SSD1306_START_LINE_LINK_OPS + 1)
+#endif
+
+// Buffer pieces ssd1306_i2c_create_static carves after the display's own
+#if CONFIG_SSD1306_I2C_STATIC_LINKS
+#define SSD1306_STATIC_LINK_SIZE(width, height)     DISPLAY_STATIC_ALIGN(SSD1306_LINK_SIZE(SSD1306_SHOW_LINK_OPS(width, height)))
+#else
+#define SSD1306_STATIC_LINK_SIZE(width, height)     0
+#endif
+#if CONFIG_SSD1306_I2C_SHADOW_DIFF
+#define SSD1306_STATIC_SHADOW_SIZE(width, height)   DISPLAY_STATIC_ALIGN(DISPLAY_FRAME_LEN(width, height))
+#else
+#define SSD1306_STATIC_SHADOW_SIZE(width, height)   0
+#endif
+
+/* A rectangle of GDDRAM addressed by one column/page range */
+typedef struct {
+    uint8_t              x1;
+    uint8_t              x2;
+    uint8_t              page1;
+    uint8_t              page2;
+
+    /* Address, control and range commands; must live until the link executes */
+    uint8_t              header[8];
+} ssd1306_window_t;
 
 typedef struct {
     int                  i2c_num;
     int                  reset_pin;
 
+    /* Start line the panel uses, and the command moving it; the command must
+     * live until the link executes */
+    int                  start_line;
+    uint8_t              start_line_command[3];
+
+    /* Windows planned for the next transfer */
+    ssd1306_window_t     *windows;
+    int                  max_windows;
+
+#if CONFIG_SSD1306_I2C_STATIC_LINKS
+    /* Reused command link storage: one for frame transfers, which may run on the
+     * flush task, and one for commands issued with the display locked */
+    uint8_t              *show_link;
+    size_t               show_link_size;
+    uint8_t              command_link[SSD1306_LINK_SIZE(SSD1306_COMMAND_LINK_OPS)] __attribute__((aligned(sizeof(void*))));
+#endif
+
+#if CONFIG_SSD1306_I2C_SHADOW_DIFF
+    /* Copy of what the panel GDDRAM holds; invalid until the first full transfer */
+    uint8_t              *shadow;
+    bool                 shadow_valid;
+#endif
+
     /* Place to save the original display close */
     void                 (*close)(display_t*);
 } ssd1306_i2c_driver_info;
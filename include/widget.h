@@ -0,0 +1,102 @@
+/*
+ * widget.h
+ *
+ * Retained widgets on top of a display_t.
+ *
+ * A screen holds a list of caller-owned widgets in z-order (later widgets on
+ * top).  Setting a property only marks that widget invalid; widget_render()
+ * erases and redraws the invalid widgets, plus any widget sharing pixels with
+ * them, and flushes once, so only the changed regions reach the panel.
+ *
+ * Widgets are meant to be changed and rendered from one task.
+ */
+#ifndef __widget_h_included
+#define __widget_h_included
+
+#include "sdkconfig.h"
+
+#if CONFIG_DISPLAY_WIDGETS_ENABLED
+
+#include <stdbool.h>
+
+#include "display.h"
+
+typedef enum {
+    widget_type_label,
+    widget_type_value,
+    widget_type_icon,
+    widget_type_progress_bar,
+    widget_type_box,
+} widget_type_t;
+
+typedef struct widget widget_t;
+
+struct widget {
+    widget_t           *next;           /* Next widget up in z-order */
+    widget_type_t      type;
+
+    /* Bounds; the widget draws nothing outside them */
+    int                x;
+    int                y;
+    int                width;
+    int                height;
+
+    bool               visible;
+    bool               invalid;         /* Needs erasing and redrawing */
+
+    union {
+        struct {
+            display_align_t align;
+            char            text[CONFIG_DISPLAY_WIDGET_TEXT_LENGTH];
+            const char      *format;    /* Value fields: printf format for the value */
+            int             value;
+        } label;
+        struct {
+            bitmap_t       *bitmap;
+        } icon;
+        struct {
+            int            range;
+            int            value;
+            bool           percent;     /* Show the value as a percentage inside the bar */
+        } progress_bar;
+        struct {
+            draw_flags_t   flags;
+        } box;
+    };
+};
+
+typedef struct {
+    display_t          *display;
+    widget_t           *first;          /* Bottom of the z-order */
+    widget_t           *last;
+} widget_screen_t;
+
+void widget_screen_init(widget_screen_t *screen, display_t *display);
+
+/*
+ * Each init call sets up *widget and adds it on top of the screen's widgets.  It
+ * starts visible and invalid, so the next widget_render() draws it.  Text and
+ * value fields are one line of the display's current font high.
+ */
+void widget_label_init(widget_screen_t *screen, widget_t *widget, int x, int y, int width, display_align_t align, const char *text);
+void widget_value_init(widget_screen_t *screen, widget_t *widget, int x, int y, int width, display_align_t align, const char *format, int value);
+void widget_icon_init(widget_screen_t *screen, widget_t *widget, int x, int y, bitmap_t *bitmap);
+void widget_box_init(widget_screen_t *screen, widget_t *widget, int x, int y, int width, int height, draw_flags_t flags);
+#if CONFIG_DISPLAY_PROGRESS_BAR_ENABLED
+void widget_progress_bar_init(widget_screen_t *screen, widget_t *widget, int x, int y, int width, int height, int range, int value, bool percent);
+#endif
+
+/* Setters invalidate the widget only when the property actually changes */
+void widget_set_text(widget_t *widget, const char *text);
+void widget_set_value(widget_t *widget, int value);
+void widget_set_bitmap(widget_t *widget, bitmap_t *bitmap);
+void widget_set_progress(widget_t *widget, int value);
+void widget_set_visible(widget_t *widget, bool visible);
+void widget_invalidate(widget_t *widget);
+
+/* Redraw what changed since the last render and show it */
+void widget_render(widget_screen_t *screen);
+
+#endif /* CONFIG_DISPLAY_WIDGETS_ENABLED */
+
+#endif /* __widget_h_included */
@@ -0,0 +1,122 @@
+/*
+ * bitmap.c
+ *
+ * Decoding of compressed bitmap bits, a span at a time.
+ */
+#include "bitmap.h"
+
+void bitmap_decoder_init(bitmap_decoder_t *decoder, const bitmap_t *bitmap)
+{
+    decoder->src        = bitmap->bits;
+    decoder->format     = bitmap->format;
+    decoder->left       = 0;
+    decoder->repeat     = false;
+    decoder->flags      = 0;
+    decoder->flag_count = 0;
+    decoder->head       = 0;
+    decoder->distance   = 0;
+}
+
+static int bitmap_decode_rle(bitmap_decoder_t *decoder, int max, const uint8_t **span, bool *run)
+{
+    if (decoder->left == 0) {
+        int header = *decoder->src++;
+
+        decoder->repeat = header >= 0x80;
+        decoder->left   = decoder->repeat ? header - 0x7E : header + 1;
+    }
+
+    int count = decoder->left < max ? decoder->left : max;
+
+    *span = decoder->src;
+    *run  = decoder->repeat;
+
+    decoder->left -= count;
+
+    if (!decoder->repeat) {
+        decoder->src += count;
+    } else if (decoder->left == 0) {
+        decoder->src++;
+    }
+
+    return count;
+}
+
+/*
+ * Output goes through the window, so a span never crosses its end: matches are
+ * copied up to there, and consecutive literals are gathered up to there.
+ */
+static int bitmap_decode_lz(bitmap_decoder_t *decoder, int max, const uint8_t **span, bool *run)
+{
+    int room = 256 - decoder->head;
+    int count = 0;
+
+    if (max > room) {
+        max = room;
+    }
+
+    *span = &decoder->window[decoder->head];
+    *run  = false;
+
+    if (decoder->left == 0) {
+        /* Literals until a match, the window end or max */
+        while (count < max) {
+            if (decoder->flag_count == 0) {
+                decoder->flags      = *decoder->src++;
+                decoder->flag_count = 8;
+            }
+
+            if (decoder->flags & 0x01) {
+                decoder->distance = decoder->src[0] + 1;
+                decoder->left     = decoder->src[1] + 3;
+                decoder->src     += 2;
+                decoder->flags  >>= 1;
+                decoder->flag_count--;
+                break;
+            }
+
+            decoder->window[decoder->head + count++] = *decoder->src++;
+            decoder->flags >>= 1;
+            decoder->flag_count--;
+        }
+
+        if (count > 0) {
+            decoder->head += count;
+            return count;
+        }
+    }
+
+    count = decoder->left < max ? decoder->left : max;
+
+    /* Byte by byte: the source may overlap what is being written */
+    for (int index = 0; index < count; ++index) {
+        uint8_t at = decoder->head + index;
+
+        decoder->window[at] = decoder->window[(uint8_t) (at - decoder->distance)];
+    }
+
+    decoder->head += count;
+    decoder->left -= count;
+
+    return count;
+}
+
+int bitmap_decoder_next(bitmap_decoder_t *decoder, int max, const uint8_t **span, bool *run)
+{
+    if (max <= 0) {
+        return 0;
+    }
+
+    if (decoder->format == bitmap_format_rle) {
+        return bitmap_decode_rle(decoder, max, span, run);
+    } else if (decoder->format == bitmap_format_lz) {
+        return bitmap_decode_lz(decoder, max, span, run);
+    }
+
+    /* Raw bits pass straight through */
+    *span = decoder->src;
+    *run  = false;
+    decoder->src += max;
+
+    return max;
+}
@@ -5,6 +5,7 @@
 
 #if CONFIG_SSD1306_I2C_ENABLED
 
+#include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
 
@@ -12,330 +13,1752 @@
 #include "driver/i2c.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#if CONFIG_DISPLAY_RENDER_QUEUE
+#include "esp_timer.h"
+#endif
+
+#include "display.h"
+#include "display_trace.h"
+
+#define TAG "display"
+
+static void display_lock(display_t* display)
+{
+    xSemaphoreTakeRecursive(display->mutex, portMAX_DELAY);
+}
+
+static void display_unlock(display_t* display)
+{
+    xSemaphoreGiveRecursive(display->mutex);
+}
+
+/*
+ * Record a rectangle as modified.  The rectangle is clipped to the display and
+ * widens the column range of every page it touches.
+ */
+static void display_mark_dirty(display_t *display, int x, int y, int width, int height)
+{
+    int x1 = x < 0 ? 0 : x;
+    int x2 = x + width - 1;
+    int y1 = y < 0 ? 0 : y;
+    int y2 = y + height - 1;
+
+    if (x2 >= display->width) {
+        x2 = display->width - 1;
+    }
+
+    if (y2 >= display->height) {
+        y2 = display->height - 1;
+    }
+
+    if (x1 <= x2 && y1 <= y2) {
+        for (int page = y1 / 8; page <= y2 / 8; ++page) {
+            display_dirty_t *dirty = &display->dirty[page];
+
+            if (x1 < dirty->x1) {
+                dirty->x1 = x1;
+            }
+            if (x2 > dirty->x2) {
+                dirty->x2 = x2;
+            }
+        }
+    }
+}
+
+static void display_clear(display_t *display)
+{
+    DISPLAY_TRACE(display_trace_op_clear, 0, 0, 0, 0);
+
+    memset(display->frame_buf, 0, display->frame_len);
+
+    display_mark_dirty(display, 0, 0, display->width, display->height);
+}
+
+static void display_hold(display_t *display)
+{
+    display->hold_count++;
+}
+
+#if CONFIG_DISPLAY_ASYNC_FLUSH
+#define DISPLAY_FLUSH_IDLE      0x01    /* Every requested frame has been flushed */
+#define DISPLAY_FLUSH_EXITED    0x02    /* Flush task has terminated */
+
+/*
+ * Background flush.  Each wakeup copies the dirty part of the frame buffer to the
+ * show buffer under the lock, then transmits it without the lock so drawing can
+ * continue.  Shows requested during a transfer coalesce into the next wakeup.
+ */
+static void display_flush_task(void *param)
+{
+    display_t *display = (display_t *) param;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        if (__atomic_load_n(&display->flush_exit, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        display->_lock(display);
+
+        uint32_t shows = display->stats.shows;
+
+        /* Leftover wakeup for shows the last transfer already covered */
+        if (shows == display->flushed) {
+            display->_unlock(display);
+            continue;
+        }
+
+#if CONFIG_DISPLAY_SCROLL_ENABLED
+        /* No GDDRAM writes during a hardware scroll; the pages stay dirty until stop_scroll */
+        if (display->scrolling) {
+            display->flushed = shows;
+            xEventGroupSetBits(display->flush_events, DISPLAY_FLUSH_IDLE);
+            display->_unlock(display);
+            continue;
+        }
+#endif
+
+        if (shows - display->flushed > 1) {
+            display->stats.coalesced += shows - display->flushed - 1;
+        }
+
+        for (int page = 0; page < display->pages; ++page) {
+            display_dirty_t *dirty = &display->dirty[page];
+
+            if (dirty->x1 <= dirty->x2) {
+                display_dirty_t *show_dirty = &display->show_dirty[page];
+                int offset = page * display->width + dirty->x1;
+
+                memcpy(&display->show_buf[offset], &display->frame_buf[offset], dirty->x2 - dirty->x1 + 1);
+
+                if (dirty->x1 < show_dirty->x1) {
+                    show_dirty->x1 = dirty->x1;
+                }
+                if (dirty->x2 > show_dirty->x2) {
+                    show_dirty->x2 = dirty->x2;
+                }
+
+                dirty->x1 = display->width;
+                dirty->x2 = -1;
+            }
+        }
+
+        display->show_start_line = display->start_line;
+
+        display->_unlock(display);
+
+        display->_show(display);
+
+        display->_lock(display);
+
+        display->flushed = shows;
+
+        if (display->stats.shows == shows) {
+            xEventGroupSetBits(display->flush_events, DISPLAY_FLUSH_IDLE);
+        }
+
+        display->_unlock(display);
+    }
+
+    xEventGroupSetBits(display->flush_events, DISPLAY_FLUSH_EXITED);
+
+    /* Close deletes the task once it is parked, so its storage can be reused at once */
+    vTaskSuspend(NULL);
+}
+#endif /* CONFIG_DISPLAY_ASYNC_FLUSH */
+
+static void display_show(display_t *display)
+{
+    display->_lock(display);
+
+    DISPLAY_TRACE(display_trace_op_show, display->stats.shows, display->hold_count, 0, 0);
+
+    if (display->hold_count > 0) {
+        display->hold_count--;
+    }
+    if (display->hold_count == 0) {
+        display->stats.shows++;
+
+#if CONFIG_DISPLAY_SCROLL_ENABLED
+        /* No GDDRAM writes during a hardware scroll; the pages stay dirty until stop_scroll */
+        if (display->scrolling) {
+            display->_unlock(display);
+            return;
+        }
+#endif
+
+#if CONFIG_DISPLAY_ASYNC_FLUSH
+        if (display->flush_task != NULL) {
+            xEventGroupClearBits(display->flush_events, DISPLAY_FLUSH_IDLE);
+            xTaskNotifyGive(display->flush_task);
+        } else {
+            display->show_start_line = display->start_line;
+            display->_show(display);
+        }
+#else
+        display->show_start_line = display->start_line;
+        display->_show(display);
+#endif
+    }
+
+    display->_unlock(display);
+}
+
+/*
+ * Wait until every frame requested by show() has reached the panel.  Must not be
+ * called with the display locked.  Returns false on timeout.
+ */
+static bool display_wait_flushed(display_t *display, TickType_t timeout)
+{
+#if CONFIG_DISPLAY_ASYNC_FLUSH
+    if (display->flush_task != NULL) {
+        return (xEventGroupWaitBits(display->flush_events, DISPLAY_FLUSH_IDLE, pdFALSE, pdTRUE, timeout) & DISPLAY_FLUSH_IDLE) != 0;
+    }
+#endif
+
+    return true;
+}
+
+/*
+ * Columns are combined a machine word at a time: a word holds that many adjacent
+ * page bytes, so shifts are masked per byte to keep bits inside their column.
+ */
+typedef uintptr_t display_word_t;
+
+#define DISPLAY_WORD_ONES   ((display_word_t) -1 / 0xFF)    /* 0x01 in every byte */
+
+static inline display_word_t display_load_word(const uint8_t *p)
+{
+    display_word_t word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+static inline void display_store_word(uint8_t *p, display_word_t word)
+{
+    memcpy(p, &word, sizeof(word));
+}
+
+/*
+ * Combine one page row of count columns into dst.  Each source byte is
+ * (hi << shift) | (lo >> (8 - shift)), where hi is the bitmap page overlapping the
+ * bottom of the destination page and lo the one above it (either may be NULL
+ * when outside the bitmap), then limited to the rows in mask.  Inlined with a
+ * constant method so the blend does not branch inside the loops.
+ */
+static inline __attribute__((always_inline)) void display_blit_row(uint8_t *dst, const uint8_t *hi, const uint8_t *lo, int count, int shift, uint8_t mask, bitmap_method_t method)
+{
+    display_word_t hi_mask = DISPLAY_WORD_ONES * (uint8_t) (0xFF << shift);
+    display_word_t lo_mask = DISPLAY_WORD_ONES * (uint8_t) (0xFF >> (8 - shift));
+    display_word_t word_mask = DISPLAY_WORD_ONES * mask;
+
+    int col = 0;
+
+    for (; col + (int) sizeof(display_word_t) <= count; col += sizeof(display_word_t)) {
+        display_word_t value = 0;
+
+        if (hi != NULL) {
+            value = (display_load_word(hi + col) << shift) & hi_mask;
+        }
+        if (lo != NULL) {
+            value |= (display_load_word(lo + col) >> (8 - shift)) & lo_mask;
+        }
+
+        value &= word_mask;
+
+        display_word_t word = display_load_word(dst + col);
+
+        if (method == bitmap_method_XOR) {
+            word ^= value;
+        } else if (method == bitmap_method_NAND) {
+            word &= ~value;
+        } else {
+            word |= value;
+        }
+
+        display_store_word(dst + col, word);
+    }
+
+    for (; col < count; ++col) {
+        uint8_t value = 0;
+
+        if (hi != NULL) {
+            value = hi[col] << shift;
+        }
+        if (lo != NULL) {
+            value |= lo[col] >> (8 - shift);
+        }
+
+        value &= mask;
+
+        if (method == bitmap_method_XOR) {
+            dst[col] ^= value;
+        } else if (method == bitmap_method_NAND) {
+            dst[col] &= ~value;
+        } else {
+            dst[col] |= value;
+        }
+    }
+}
+
+/*
+ * Apply a solid run: the rows in mask set, cleared or inverted over count
+ * columns.  Inlined with a constant method like display_blit_row.
+ */
+static inline __attribute__((always_inline)) void display_fill_words(uint8_t *dst, int count, uint8_t mask, bitmap_method_t method)
+{
+    display_word_t word_mask = DISPLAY_WORD_ONES * mask;
+
+    int col = 0;
+
+    for (; col + (int) sizeof(display_word_t) <= count; col += sizeof(display_word_t)) {
+        display_word_t word = display_load_word(dst + col);
+
+        if (method == bitmap_method_XOR) {
+            word ^= word_mask;
+        } else if (method == bitmap_method_NAND) {
+            word &= ~word_mask;
+        } else {
+            word |= word_mask;
+        }
+
+        display_store_word(dst + col, word);
+    }
+
+    for (; col < count; ++col) {
+        if (method == bitmap_method_XOR) {
+            dst[col] ^= mask;
+        } else if (method == bitmap_method_NAND) {
+            dst[col] &= ~mask;
+        } else {
+            dst[col] |= mask;
+        }
+    }
+}
+
+static void display_fill_row(uint8_t *dst, int count, uint8_t mask, bitmap_method_t method)
+{
+    if (mask == 0xFF && method != bitmap_method_XOR) {
+        /* Whole page bytes */
+        memset(dst, method == bitmap_method_NAND ? 0x00 : 0xFF, count);
+    } else if (method == bitmap_method_XOR) {
+        display_fill_words(dst, count, mask, bitmap_method_XOR);
+    } else if (method == bitmap_method_NAND) {
+        display_fill_words(dst, count, mask, bitmap_method_NAND);
+    } else {
+        display_fill_words(dst, count, mask, bitmap_method_OR);
+    }
+}
+
+/*
+ * Set, clear or invert the solid rectangle x1,y1 .. x2,y2 (inclusive, clipped).
+ * Each page it touches gets one mask for its top/bottom rows applied across
+ * the column range.  Caller holds the lock.
+ */
+static void display_fill_span(display_t *display, int x1, int y1, int x2, int y2, bitmap_method_t method)
+{
+    if (x1 < 0) {
+        x1 = 0;
+    }
+    if (y1 < 0) {
+        y1 = 0;
+    }
+    if (x2 >= display->width) {
+        x2 = display->width - 1;
+    }
+    if (y2 >= display->height) {
+        y2 = display->height - 1;
+    }
+
+    if (x1 <= x2 && y1 <= y2) {
+        display_mark_dirty(display, x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+
+        for (int page = y1 / 8; page <= y2 / 8; ++page) {
+            uint8_t mask = 0xFF;
+
+            if (page == y1 / 8) {
+                mask &= 0xFF << (y1 % 8);
+            }
+            if (page == y2 / 8) {
+                mask &= 0xFF >> (7 - y2 % 8);
+            }
+
+            display_fill_row(&display->frame_buf[page * display->width + x1], x2 - x1 + 1, mask, method);
+        }
+    }
+}
+
+/* Rows of page inside the clip y1 .. y2 (exclusive), none outside it */
+static uint8_t display_page_mask(int page, int y1, int y2)
+{
+    uint8_t mask = 0xFF;
+
+    if (page < y1 / 8 || page > (y2 - 1) / 8) {
+        return 0;
+    }
+    if (page == y1 / 8) {
+        mask &= 0xFF << (y1 % 8);
+    }
+    if (page == (y2 - 1) / 8) {
+        mask &= 0xFF >> (7 - (y2 - 1) % 8);
+    }
+
+    return mask;
+}
+
+/*
+ * Blend count decoded bytes of one bitmap page onto a display page row: the
+ * upper part (bits << shift) onto the page the bitmap page starts on, or the
+ * lower part (bits >> (8 - shift)) onto the one below.  A run is one byte
+ * repeated, so it is a solid fill, and nothing at all when it lands blank.
+ */
+static void display_blend_span(uint8_t *dst, const uint8_t *src, bool run, int count, int shift, bool upper, uint8_t mask, bitmap_method_t method)
+{
+    if (run) {
+        uint8_t value = (upper ? *src << shift : *src >> (8 - shift)) & mask;
+
+        if (value != 0) {
+            display_fill_row(dst, count, value, method);
+        }
+        return;
+    }
+
+    const uint8_t *hi = upper ? src : NULL;
+    const uint8_t *lo = upper ? NULL : src;
+
+    if (method == bitmap_method_XOR) {
+        display_blit_row(dst, hi, lo, count, shift, mask, bitmap_method_XOR);
+    } else if (method == bitmap_method_NAND) {
+        display_blit_row(dst, hi, lo, count, shift, mask, bitmap_method_NAND);
+    } else {
+        display_blit_row(dst, hi, lo, count, shift, mask, bitmap_method_OR);
+    }
+}
+
+/*
+ * render_bitmap for compressed bits: decoded spans go straight into the frame
+ * buffer, each bitmap page onto the one or two display pages it covers, so
+ * nothing bigger than the decoder is needed.  Decoding stops after the last
+ * page inside the clip.
+ */
+static void display_blit_stream(display_t *display, const bitmap_t *bitmap, int x, int x1, int x2, int y1, int y2, int base, int shift, bitmap_method_t method)
+{
+    bitmap_decoder_t decoder;
+    int pages = (bitmap->height + 7) / 8;
+
+    if (pages > (y2 - 1) / 8 - base + 1) {
+        pages = (y2 - 1) / 8 - base + 1;
+    }
+
+    bitmap_decoder_init(&decoder, bitmap);
+
+    for (int q = 0; q < pages; ++q) {
+        int page = base + q;
+        uint8_t upper_mask = display_page_mask(page, y1, y2);
+        uint8_t lower_mask = shift != 0 ? display_page_mask(page + 1, y1, y2) : 0;
+
+        for (int col = 0; col < bitmap->width;) {
+            const uint8_t *span;
+            bool run;
+            int count = bitmap_decoder_next(&decoder, bitmap->width - col, &span, &run);
+
+            /* Columns of the span inside the clip */
+            int from = x1 - x > col ? x1 - x : col;
+            int to = x2 - x < col + count ? x2 - x : col + count;
+
+            if (from < to) {
+                const uint8_t *src = run ? span : span + from - col;
+
+                if (upper_mask != 0) {
+                    display_blend_span(&display->frame_buf[page * display->width + x + from], src, run, to - from, shift, true, upper_mask, method);
+                }
+                if (lower_mask != 0) {
+                    display_blend_span(&display->frame_buf[(page + 1) * display->width + x + from], src, run, to - from, shift, false, lower_mask, method);
+                }
+            }
+
+            col += count;
+        }
+    }
+}
+
+/*
+ * Put the bitmap into the frame buffer at x, y.  x,y is the top left corner
+ * (x, y, width, height) are the dimensions of the region to be overlayed with the bitmap.
+ * Extra space is ignore.  Insufficient space causes truncation.  A bitmap with
+ * no bits is solid.
+ *
+ * Works a destination page at a time: each page row is built from at most two
+ * bitmap pages, shifted by y % 8, and blended a word of columns at a time.
+ */
+static void display_render_bitmap(display_t *display, bitmap_t *bitmap, int x, int y, int width, int height, bitmap_method_t method)
+{
+    DISPLAY_TRACE(display_trace_op_draw_bitmap, x, y, width, height);
+
+    if (width > bitmap->width) {
+        width = bitmap->width;
+    }
+    if (height > bitmap->height) {
+        height = bitmap->height;
+    }
+
+    /* Clip to the display; skip_x is the first bitmap column drawn */
+    int skip_x = x < 0 ? -x : 0;
+    int x1 = x + skip_x;
+    int x2 = x + width < display->width ? x + width : display->width;
+    int y1 = y < 0 ? 0 : y;
+    int y2 = y + height < display->height ? y + height : display->height;
+
+    if (x1 < x2 && y1 < y2) {
+        int count = x2 - x1;
+
+        /* Bitmap page q lands on display page q + base, shifted down by shift rows */
+        int base = y >= 0 ? y / 8 : -((7 - y) / 8);
+        int shift = y - base * 8;
+        int pages = (bitmap->height + 7) / 8;
+
+        display_mark_dirty(display, x1, y1, count, y2 - y1);
+
+        if (bitmap->bits != NULL && bitmap->format != bitmap_format_raw) {
+            display_blit_stream(display, bitmap, x, x1, x2, y1, y2, base, shift, method);
+            return;
+        }
+
+        for (int page = y1 / 8; page <= (y2 - 1) / 8; ++page) {
+            uint8_t *dst = &display->frame_buf[page * display->width + x1];
+
+            /* Rows of this page inside the clip */
+            uint8_t mask = 0xFF;
+
+            if (page == y1 / 8) {
+                mask &= 0xFF << (y1 % 8);
+            }
+            if (page == (y2 - 1) / 8) {
+                mask &= 0xFF >> (7 - (y2 - 1) % 8);
+            }
+
+            if (bitmap->bits == NULL) {
+                display_fill_row(dst, count, mask, method);
+            } else {
+                int q = page - base;
+
+                const uint8_t *hi = q >= 0 && q < pages ? &bitmap->bits[q * bitmap->width + skip_x] : NULL;
+                const uint8_t *lo = shift != 0 && q >= 1 && q <= pages ? &bitmap->bits[(q - 1) * bitmap->width + skip_x] : NULL;
+
+                if (method == bitmap_method_XOR) {
+                    display_blit_row(dst, hi, lo, count, shift, mask, bitmap_method_XOR);
+                } else if (method == bitmap_method_NAND) {
+                    display_blit_row(dst, hi, lo, count, shift, mask, bitmap_method_NAND);
+                } else {
+                    display_blit_row(dst, hi, lo, count, shift, mask, bitmap_method_OR);
+                }
+            }
+        }
+    }
+}
+
+#if CONFIG_DISPLAY_GLYPH_CACHE
+/*
+ * Find or build the cache entry for a glyph drawn shift rows below a page
+ * boundary: the glyph's columns split into the parts landing on the first and
+ * the second page.  Two-way set associative, the most recent way first; a miss
+ * drops the older way.
+ */
+static const display_glyph_t *display_glyph_lookup(display_t *display, const font_t *font, int ch, const bitmap_t *bitmap, int shift)
+{
+    uint32_t key = ((uint32_t) ch * 8 + shift) ^ (uint32_t) ((uintptr_t) font >> 4);
+    display_glyph_t *set = &display->glyph_cache[2 * (((key * 2654435761u) >> 16) % (CONFIG_DISPLAY_GLYPH_CACHE_ENTRIES / 2))];
+    display_glyph_t *glyph = &set[0];
+
+    if (set[0].font == font && set[0].ch == ch && set[0].shift == shift) {
+#if CONFIG_DISPLAY_GLYPH_CACHE_STATS
+        display->stats.glyph_hits++;
+#endif
+        return glyph;
+    }
+
+    display_glyph_t older = set[1];
+
+    set[1] = set[0];
+
+    if (older.font == font && older.ch == ch && older.shift == shift) {
+#if CONFIG_DISPLAY_GLYPH_CACHE_STATS
+        display->stats.glyph_hits++;
+#endif
+        set[0] = older;
+        return glyph;
+    }
+
+#if CONFIG_DISPLAY_GLYPH_CACHE_STATS
+    display->stats.glyph_misses++;
+#endif
+
+    uint8_t rows = 0xFF >> (8 - bitmap->height);
+
+    glyph->font  = font;
+    glyph->ch    = ch;
+    glyph->shift = shift;
+    glyph->width = bitmap->width;
+
+    const uint8_t *src = bitmap->bits;
+
+    /* A compressed glyph is decoded straight into the first strip */
+    if (bitmap->format != bitmap_format_raw) {
+        bitmap_decoder_t decoder;
+
+        bitmap_decoder_init(&decoder, bitmap);
+
+        for (int col = 0; col < bitmap->width;) {
+            const uint8_t *span;
+            bool run;
+            int count = bitmap_decoder_next(&decoder, bitmap->width - col, &span, &run);
+
+            for (int i = 0; i < count; ++i) {
+                glyph->strips[0][col + i] = run ? span[0] : span[i];
+            }
+            col += count;
+        }
+        src = glyph->strips[0];
+    }
+
+    for (int col = 0; col < bitmap->width; ++col) {
+        uint8_t bits = src[col] & rows;
+
+        glyph->strips[0][col] = bits << shift;
+        glyph->strips[1][col] = shift != 0 ? bits >> (8 - shift) : 0;
+    }
+
+    return glyph;
+}
+#endif
+
+/*
+ * Draw a font glyph, height rows of it at most.  With the glyph cache, glyphs of
+ * one page or less that fit vertically are blended from their pre-shifted strips.
+ */
+static void display_render_glyph(display_t *display, const font_t *font, int ch, bitmap_t *bitmap, int x, int y, int height, bitmap_method_t method)
+{
+#if CONFIG_DISPLAY_GLYPH_CACHE
+    if (height >= bitmap->height && bitmap->height <= 8 && bitmap->width <= CONFIG_DISPLAY_GLYPH_CACHE_WIDTH &&
+        bitmap->bits != NULL && y >= 0 && y + bitmap->height <= display->height) {
+        DISPLAY_TRACE(display_trace_op_draw_bitmap, x, y, bitmap->width, bitmap->height);
+
+        int x1 = x < 0 ? 0 : x;
+        int x2 = x + bitmap->width < display->width ? x + bitmap->width : display->width;
+
+        if (x1 >= x2) {
+            return;
+        }
+
+        const display_glyph_t *glyph = display_glyph_lookup(display, font, ch, bitmap, y % 8);
+        int count = x2 - x1;
+
+        display_mark_dirty(display, x1, y, count, bitmap->height);
+
+        /* The second strip is empty unless the glyph crosses a page boundary */
+        for (int strip = 0; strip <= (y + bitmap->height - 1) / 8 - y / 8; ++strip) {
+            uint8_t *dst = &display->frame_buf[(y / 8 + strip) * display->width + x1];
+            const uint8_t *src = &glyph->strips[strip][x1 - x];
+
+            if (method == bitmap_method_XOR) {
+                for (int col = 0; col < count; ++col) {
+                    dst[col] ^= src[col];
+                }
+            } else if (method == bitmap_method_NAND) {
+                for (int col = 0; col < count; ++col) {
+                    dst[col] &= ~src[col];
+                }
+            } else {
+                for (int col = 0; col < count; ++col) {
+                    dst[col] |= src[col];
+                }
+            }
+        }
+
+        return;
+    }
+#endif
+
+    display_render_bitmap(display, bitmap, x, y, bitmap->width, height, method);
+}
+
+static void display_draw_bitmap(display_t *display, bitmap_t *bitmap, int x, int y, int width, int height, bitmap_method_t method)
+{
+    display->_lock(display);
+
+    display->hold(display);
+
+    display_render_bitmap(display, bitmap, x, y, width, height, method);
+
+    display->show(display);
+
+    display->_unlock(display);
+}
+
+#if CONFIG_DISPLAY_PIXEL_ENABLED
+static void display_render_pixel(display_t *display, int x, int y, bool set)
+{
+DISPLAY_LOGI(TAG, "%s: %d,%d %s", __func__, x, y, set ? "DRAW" : "ERASE");
+    DISPLAY_TRACE(display_trace_op_draw_pixel, x, y, set, 0);
+
+    if (x >= 0 && x < display->width && y >= 0 && y < display->height) {
+        uint8_t *byte = &display->frame_buf[(y/8) * display->width + x];
+
+        if (set) {
+            *byte |= 1 << (y % 8);
+        } else {
+            *byte &= ~(1 << (y % 8));
+        }
+
+        display_mark_dirty(display, x, y, 1, 1);
+    }
+}
+
+static void display_draw_pixel(display_t *display, int x, int y, bool set)
+{
+    display->_lock(display);
+
+    display->hold(display);
+
+    display_render_pixel(display, x, y, set);
+
+    display->show(display);
+
+    display->_unlock(display);
+}
+#endif
+
+#if CONFIG_DISPLAY_LINE_ENABLED
+/*
+ * Draw a line including both end points.  Horizontal and vertical lines are
+ * spans (one mask per page); other lines run Bresenham straight into the frame
+ * buffer with a single dirty box for the line.
+ */
+static void display_render_line(display_t *display, int x1, int y1, int x2, int y2, bool set)
+{
+DISPLAY_LOGI(TAG, "%s: %d,%d to %d,%d  set %s", __func__, x1, y1, x2, y2, set ? "DRAW" : "ERASE");
+    DISPLAY_TRACE(display_trace_op_draw_line, x1, y1, x2, y2);
+
+    if (y1 == y2 || x1 == x2) {
+        display_fill_span(display, x1 < x2 ? x1 : x2, y1 < y2 ? y1 : y2, x1 < x2 ? x2 : x1, y1 < y2 ? y2 : y1, set ? bitmap_method_OR : bitmap_method_NAND);
+    } else {
+        int dx =  abs(x2-x1);
+        int sx = x1<x2 ? 1 : -1;
+        int dy = -abs(y2-y1);
+        int sy = y1<y2 ? 1 : -1;
+        int err = dx+dy;
+
+        display_mark_dirty(display, x1 < x2 ? x1 : x2, y1 < y2 ? y1 : y2, dx + 1, 1 - dy);
+
+        while (true) {
+            if ((unsigned) x1 < (unsigned) display->width && (unsigned) y1 < (unsigned) display->height) {
+                uint8_t *byte = &display->frame_buf[(y1/8) * display->width + x1];
+
+                if (set) {
+                    *byte |= 1 << (y1 % 8);
+                } else {
+                    *byte &= ~(1 << (y1 % 8));
+                }
+            }
+
+            if (x1 == x2 && y1 == y2) {
+                break;
+            }
+
+            int e2 = 2*err;
+            if (e2 >= dy) {
+                err += dy;
+                x1 += sx;
+            }
+
+            if (e2 <= dx) {
+                err += dx;
+                y1 += sy;
+            }
+        }
+    }
+}
+
+static void display_draw_line(display_t *display, int x1, int y1, int x2, int y2, bool set)
+{
+    display->_lock(display);
+
+    display->hold(display);
+
+    display_render_line(display, x1, y1, x2, y2, set);
+
+    display->show(display);
+
+    display->_unlock(display);
+}
+#endif
+
+#if CONFIG_DISPLAY_RECTANGLE_ENABLED
+static void display_render_rectangle(display_t *display, int x, int y, int width, int height, draw_flags_t flags)
+{
+DISPLAY_LOGI(TAG, "%s: x %d y %d width %d height %d flags %02x", __func__, x, y, width, height, flags);
+    DISPLAY_TRACE(display_trace_op_draw_rectangle, x, y, width, height);
+
+    int x1 = x;
+    int x2 = x + width - 1;
+    int y1 = y;
+    int y2 = y + height - 1;
+
+    /* Entirely off screen */
+    if (x2 < 0 || y2 < 0 || x1 >= display->width || y1 >= display->height) {
+        return;
+    }
+
+    if (x1 < 0) {
+        x1 = 0;
+    }
+
+    if (x2 >= display->width) {
+        x2 = display->width - 1;
+    }
+
+    if (y1 < 0) {
+        y1 = 0;
+    }
+
+    if (y2 >= display->height) {
+        y2 = display->height - 1;
+    }
+
+    if (flags & draw_flag_border) {
+        display_render_line(display, x1, y1, x2, y1, !(flags & draw_flag_clear));
+        display_render_line(display, x2, y1, x2, y2, !(flags & draw_flag_clear));
+        display_render_line(display, x2, y2, x1, y2, !(flags & draw_flag_clear));
+        display_render_line(display, x1, y2, x1, y1, !(flags & draw_flag_clear));
+        x1++;
+        y1++;
+        x2--;
+        y2--;
+    }
+        
+    if (flags & (draw_flag_fill | draw_flag_clear)) {
+        display_fill_span(display, x1, y1, x2, y2, (flags & draw_flag_clear) ? bitmap_method_NAND : bitmap_method_OR);
+    }
+}
+
+static void display_draw_rectangle(display_t *display, int x, int y, int width, int height, draw_flags_t flags)
+{
+    display->_lock(display);
+
+    display->hold(display);
+
+    display_render_rectangle(display, x, y, width, height, flags);
+
+    display->show(display);
+
+    display->_unlock(display);
+}
+#endif
+
+/*
+ * Draw text in rectangle at x, y
+ */
+static void display_render_text(display_t *display, int x, int y, const char* text)
+{
+    DISPLAY_TRACE(display_trace_op_draw_text, x, y, strlen(text), 0);
+
+    int textx = x;
+    int texty = y;
+
+    while (*text != '\0' && textx < display->width - 1) {
+        const char *next = text;
+        int ch = text_next_char(&next);
+        bitmap_t bitmap;
+
+        if (ch == '\n' || (char_to_bitmap(&bitmap, display->font, ch) != NULL && textx + bitmap.width >= display->width)) {
+            /* Advance a line */
+            texty += display->font_height;
+
+            /* Reset X */
+            textx = x;
+
+            if (ch == '\n') {
+                text = next;
+            }
+
+            if (texty >= display->height) {
+                /* Off the bottom (or a glyph that never fits at x) */
+                break;
+            }
+        } else if (bitmap.bits == NULL) {
+            /* No glyph and no replacement: skip it */
+            text = next;
+        } else if (texty + bitmap.height <= display->height) {
+            display_render_glyph(display, display->font, ch, &bitmap, textx, texty, bitmap.height, bitmap_method_XOR);
+            textx += bitmap.width;
+            text = next;
+        } else {
+            /* No room left below */
+            break;
+        }
+    }
+}
+
+static void display_draw_text(display_t *display, int x, int y, const char* text)
+{
+    display->_lock(display);
+
+    display->hold(display);
+
+    display_render_text(display, x, y, text);
+
+    display->show(display);
+
+    display->_unlock(display);
+}
+
+/* draw_text with printf formatting; output past DISPLAY_TEXTF_LENGTH is cut */
+static void display_draw_textf(display_t *display, int x, int y, const char *format, ...)
+{
+    char text[DISPLAY_TEXTF_LENGTH];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    text_trim_utf8(text);
+
+    display_draw_text(display, x, y, text);
+}
+
+/*
+ * Decode text into chars and find where each glyph goes in a field, up to the
+ * field width.  Returns the number of glyphs placed; positions[n] is the x
+ * after the last.
+ */
+static int display_field_layout(const display_text_field_t *field, const char *text, int *chars, int *positions)
+{
+    int x = field->x;
+    int count = 0;
+
+    while (*text != '\0') {
+        bitmap_t bitmap;
+        int ch = text_next_char(&text);
+        int width = char_to_bitmap(&bitmap, field->font, ch) != NULL ? bitmap.width : 0;
+
+        if (x + width > field->x + field->width) {
+            break;
+        }
+
+        chars[count] = ch;
+        positions[count] = x;
+        x += width;
+        ++count;
+    }
+
+    positions[count] = x;
+
+    return count;
+}
+
+/*
+ * Format into a text field and redraw only the glyph cells that differ from what
+ * the field shows: a cell is kept when both its character and its position are
+ * unchanged.  The first draw, or a font change, clears the whole field.
+ */
+static void display_draw_field(display_t *display, display_text_field_t *field, const char *format, ...)
+{
+    char text[DISPLAY_TEXT_FIELD_LENGTH];
+    int old_ch[DISPLAY_TEXT_FIELD_LENGTH];
+    int new_ch[DISPLAY_TEXT_FIELD_LENGTH];
+    int old_x[DISPLAY_TEXT_FIELD_LENGTH];
+    int new_x[DISPLAY_TEXT_FIELD_LENGTH];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    text_trim_utf8(text);
+
+    display->_lock(display);
+
+    display->hold(display);
+
+    if (field->font != display->font) {
+        field->font    = display->font;
+        field->height  = display->font_height;
+        field->text[0] = '\0';
+
+        display_fill_span(display, field->x, field->y, field->x + field->width - 1, field->y + field->height - 1, bitmap_method_NAND);
+    }
+
+    int old_count = display_field_layout(field, field->text, old_ch, old_x);
+    int new_count = display_field_layout(field, text, new_ch, new_x);
+
+    /* Erase cells that go away or change, in the old layout and then the new */
+    for (int index = 0; index < old_count; ++index) {
+        if (index >= new_count || new_ch[index] != old_ch[index] || new_x[index] != old_x[index] || new_x[index + 1] != old_x[index + 1]) {
+            display_fill_span(display, old_x[index], field->y, old_x[index + 1] - 1, field->y + field->height - 1, bitmap_method_NAND);
+        }
+    }
+
+    for (int index = 0; index < new_count; ++index) {
+        if (index >= old_count || new_ch[index] != old_ch[index] || new_x[index] != old_x[index] || new_x[index + 1] != old_x[index + 1]) {
+            bitmap_t bitmap;
+
+            display_fill_span(display, new_x[index], field->y, new_x[index + 1] - 1, field->y + field->height - 1, bitmap_method_NAND);
+
+            if (char_to_bitmap(&bitmap, field->font, new_ch[index]) != NULL) {
+                display_render_glyph(display, field->font, new_ch[index], &bitmap, new_x[index], field->y, field->height, bitmap_method_OR);
+            }
+        }
+    }
+
+    memcpy(field->text, text, sizeof(field->text));
+
+    display->show(display);
+
+    display->_unlock(display);
+}
+
+/* Advance of ch: its glyph's width, the replacement's, or 0 without either */
+static int display_char_width(const font_t *font, int ch)
+{
+    bitmap_t bitmap;
+
+    return char_to_bitmap(&bitmap, font, ch) != NULL ? bitmap.width : 0;
+}
+
+/* U+2026 when the font has it, else three full stops */
+static const char *display_ellipsis(const font_t *font)
+{
+    return font_char(font, 0x2026, NULL, NULL) != NULL ? "\xE2\x80\xA6" : "...";
+}
+
+/*
+ * Fit one line of text into width.  Sets *pend and *pwidth to the end and
+ * width of what goes on the line, trailing spaces dropped, and returns where
+ * the next line starts: past the spaces it broke at, past a '\n', or inside a
+ * word wider than the whole line.  A glyph wider than the line goes alone.
+ */
+static const char *display_layout_line(const font_t *font, int width, const char *text, const char **pend, int *pwidth)
+{
+    const char *end = text;             /* Past the last glyph that is not a space */
+    int end_width = 0;
+    int run = 0;                        /* Width up to the current glyph */
+    const char *break_end = NULL;       /* end and end_width at the last space run... */
+    int break_width = 0;
+    const char *resume = NULL;          /* ... and the text after it */
+    const char *p = text;
+
+    for (;;) {
+        const char *next = p;
+        int ch = text_next_char(&next);
+
+        if (ch == '\0' || ch == '\n') {
+            break;
+        }
+
+        int cwidth = display_char_width(font, ch);
+
+        if (ch == ' ') {
+            if (break_end != end) {
+                break_end = end;
+                break_width = end_width;
+            }
+            resume = next;
+        } else if (run + cwidth > width) {
+            if (break_end != NULL && break_end != text) {
+                *pend = break_end;
+                *pwidth = break_width;
+                return resume;
+            }
+            if (p == text) {
+                end = next;
+                end_width = cwidth;
+                p = next;
+            }
+            *pend = end;
+            *pwidth = end_width;
+            return p;
+        } else {
+            end = next;
+            end_width = run + cwidth;
+        }
+
+        run += cwidth;
+        p = next;
+    }
+
+    *pend = end;
+    *pwidth = end_width;
+
+    /* Past a '\n'; a NUL is never stepped over */
+    return *p != '\0' ? p + 1 : p;
+}
+
+void display_layout_text(display_text_layout_t *layout, const font_t *font, const char *text)
+{
+    snprintf(layout->text, sizeof(layout->text), "%s", text);
+    text_trim_utf8(layout->text);
+
+    layout->font  = font;
+    layout->count = 0;
+
+    int lines = font->height > 0 ? layout->height / font->height : 0;
+
+    if (lines > DISPLAY_TEXT_LAYOUT_LINES) {
+        lines = DISPLAY_TEXT_LAYOUT_LINES;
+    }
+
+    const char *next = layout->text;
+
+    while (*next != '\0' && layout->count < lines) {
+        display_text_line_t *line = &layout->lines[layout->count++];
+        const char *end;
+
+        line->start    = next - layout->text;
+        line->ellipsis = false;
+
+        next = display_layout_line(font, layout->width, next, &end, &line->width);
+        line->length = end - (layout->text + line->start);
+    }
+
+    int ellipsis_width;
+
+    text_metrics(font, display_ellipsis(font), &ellipsis_width, NULL);
+
+    /* Out of lines with text left: cut the last line back to fit an ellipsis, if one fits at all */
+    if (*next != '\0' && layout->count > 0 && ellipsis_width <= layout->width) {
+        display_text_line_t *line = &layout->lines[layout->count - 1];
+        const char *start = layout->text + line->start;
+        const char *stop = start + line->length;
+        const char *end = start;
+        int end_width = 0;
+        int width = 0;
+
+        for (const char *p = start, *after = p; p < stop; p = after) {
+            int ch = text_next_char(&after);
+
+            width += display_char_width(font, ch);
+
+            if (width + ellipsis_width > layout->width) {
+                break;
+            }
+            if (ch != ' ') {
+                end = after;
+                end_width = width;
+            }
+        }
+
+        line->length   = end - start;
+        line->width    = end_width + ellipsis_width;
+        line->ellipsis = true;
+    }
+
+    for (int index = 0; index < layout->count; ++index) {
+        display_text_line_t *line = &layout->lines[index];
+
+        line->x = layout->x;
+
+        if (layout->align == display_align_center) {
+            line->x += (layout->width - line->width) / 2;
+        } else if (layout->align == display_align_right) {
+            line->x += layout->width - line->width;
+        }
+    }
+}
+
+/* Glyphs of text up to end from x; returns the x after them */
+static int display_render_span(display_t *display, const font_t *font, const char *text, const char *end, int x, int y)
+{
+    while (text < end) {
+        bitmap_t bitmap;
+        int ch = text_next_char(&text);
+
+        if (char_to_bitmap(&bitmap, font, ch) != NULL) {
+            display_render_glyph(display, font, ch, &bitmap, x, y, bitmap.height, bitmap_method_OR);
+            x += bitmap.width;
+        }
+    }
+
+    return x;
+}
+
+/* Redraw a layout from its stored line breaks; nothing is measured again */
+static void display_draw_layout(display_t *display, const display_text_layout_t *layout)
+{
+    display->_lock(display);
+
+    DISPLAY_TRACE(display_trace_op_draw_text, layout->x, layout->y, strlen(layout->text), 0);
+
+    display->hold(display);
+
+    display_fill_span(display, layout->x, layout->y, layout->x + layout->width - 1, layout->y + layout->height - 1, bitmap_method_NAND);
+
+    for (int index = 0; index < layout->count; ++index) {
+        const display_text_line_t *line = &layout->lines[index];
+        const char *start = layout->text + line->start;
+        int y = layout->y + index * layout->font->height;
+        int x = display_render_span(display, layout->font, start, start + line->length, line->x, y);
+
+        if (line->ellipsis) {
+            const char *ellipsis = display_ellipsis(layout->font);
+
+            display_render_span(display, layout->font, ellipsis, ellipsis + strlen(ellipsis), x, y);
+        }
+    }
+
+    display->show(display);
+
+    display->_unlock(display);
+}
+
+#if CONFIG_DISPLAY_PROGRESS_BAR_ENABLED
+static void display_render_progress_bar(display_t *display, int x, int y, int width, int height, int range, int value, const char* text)
+{
+    DISPLAY_TRACE(display_trace_op_draw_progress, x, y, range, value);
+
+    /* Draw surrounding border */
+    display_render_rectangle(display, x, y, width, height, draw_flag_border);
+
+    /* Make smaller rectangle for the moving bar */
+    x += 1;
+    y += 1;
+    width -= 2;
+    height -= 2;
+
+    int bar = ((width - 1) * value) / range;
+
+    /* Paint the Progress part */
+    display_render_rectangle(display, x, y, bar, height, draw_flag_fill);
+
+    /* Paint the non-progress part */
+    if (range != value) {
+        display_render_rectangle(display, x + bar, y, width - bar, height, draw_flag_clear);
+    }
+
+    if (text != NULL) {
+        int cwidth, cheight;
+        text_metrics(display->font, text, &cwidth, &cheight);
+        display_render_text(display, x + width/2 - cwidth/2, y + height/2 - cheight/2, text);
+    }
+}
+
+void display_draw_progress_bar(display_t *display, int x, int y, int width, int height, int range, int value, const char* text)
+{
+    display->_lock(display);
+
+    display->hold(display);
+
+    display_render_progress_bar(display, x, y, width, height, range, value, text);
+
+    display->show(display);
+
+    display->_unlock(display);
+}
+
+/* Widen the half-open column span [*x1, *x2) to cover [from, to) */
+static void display_span_include(int *x1, int *x2, int from, int to)
+{
+    if (from >= to) {
+        return;
+    }
+
+    if (*x1 >= *x2) {
+        *x1 = from;
+        *x2 = to;
+    } else {
+        if (from < *x1) {
+            *x1 = from;
+        }
+        if (to > *x2) {
+            *x2 = to;
+        }
+    }
+}
+
+/*
+ * Move a progress bar drawn through a handle.  Only the columns between the old
+ * and new bar ends, plus those under changed text, are repainted; the text
+ * glyphs over them are redrawn whole, widening the span to glyph edges.  Falls
+ * back to a full draw the first time and whenever the text does not fit inside.
+ * Text that does not fit spills past the bar's edges; the next update erases
+ * that whole text rectangle, along with whatever it covered, before drawing.
+ */
+static void display_update_progress_bar(display_t *display, display_progress_bar_t *bar, int value, const char *text)
+{
+    if (text == NULL) {
+        text = "";
+    }
+
+    display->_lock(display);
+
+    display->hold(display);
+
+    int x = bar->x + 1;
+    int y = bar->y + 1;
+    int width = bar->width - 2;
+    int height = bar->height - 2;
+    int filled = ((width - 1) * value) / bar->range;
+
+    int text_width, text_height;
+    text_metrics(display->font, text, &text_width, &text_height);
+
+    int text_x = x + width/2 - text_width/2;
+    int text_y = y + height/2 - text_height/2;
+    bool fits = text_x >= x && text_x + text_width <= x + width && text_y >= y && text_y + text_height <= y + height;
+
+    if (bar->filled < 0 || !fits) {
+        /* Text that did not fit last time spilled past the bar: erase all of it */
+        if (bar->text_width > 0 && (bar->text_x < x || bar->text_x + bar->text_width > x + width ||
+                                    bar->text_y < y || bar->text_y + bar->text_height > y + height)) {
+            display_fill_span(display, bar->text_x, bar->text_y, bar->text_x + bar->text_width - 1, bar->text_y + bar->text_height - 1, bitmap_method_NAND);
+        }
+
+        display_render_progress_bar(display, bar->x, bar->y, bar->width, bar->height, bar->range, value, *text != '\0' ? text : NULL);
+    } else {
+        /* Columns to repaint, half open */
+        int x1 = x + (filled < bar->filled ? filled : bar->filled);
+        int x2 = x + (filled < bar->filled ? bar->filled : filled);
+
+        /* A label too long for the stored copy always counts as changed */
+        bool changed = strlen(text) >= sizeof(bar->text) || strcmp(bar->text, text) != 0 ||
+                       bar->text_x != text_x || bar->text_width != text_width;
+
+        if (changed) {
+            display_span_include(&x1, &x2, bar->text_x, bar->text_x + bar->text_width);
+            display_span_include(&x1, &x2, text_x, text_x + text_width);
+        }
+
+        if (x1 < x2) {
+            bitmap_t bitmap;
+            int glyph_x = text_x;
+
+            for (const char *next = text; *next != '\0';) {
+                if (char_to_bitmap(&bitmap, display->font, text_next_char(&next)) != NULL) {
+                    if (glyph_x < x2 && glyph_x + bitmap.width > x1) {
+                        display_span_include(&x1, &x2, glyph_x, glyph_x + bitmap.width);
+                    }
+                    glyph_x += bitmap.width;
+                }
+            }
+
+            int split = x + filled;
+
+            if (split > x1) {
+                display_render_rectangle(display, x1, y, (split < x2 ? split : x2) - x1, height, draw_flag_fill);
+            }
+            if (split < x2) {
+                display_render_rectangle(display, split > x1 ? split : x1, y, x2 - (split > x1 ? split : x1), height, draw_flag_clear);
+            }
+
+            glyph_x = text_x;
+
+            for (const char *next = text; *next != '\0';) {
+                int ch = text_next_char(&next);
+
+                if (char_to_bitmap(&bitmap, display->font, ch) != NULL) {
+                    if (glyph_x < x2 && glyph_x + bitmap.width > x1) {
+                        display_render_glyph(display, display->font, ch, &bitmap, glyph_x, text_y, bitmap.height, bitmap_method_XOR);
+                    }
+                    glyph_x += bitmap.width;
+                }
+            }
+        }
+    }
+
+    /* A text that did not fit forces the next update to draw in full too */
+    bar->filled      = fits ? filled : -1;
+    bar->text_x      = text_x;
+    bar->text_y      = text_y;
+    bar->text_width  = text_width;
+    bar->text_height = text_height;
+
+    strncpy(bar->text, text, sizeof(bar->text) - 1);
+    bar->text[sizeof(bar->text) - 1] = '\0';
+
+    display->show(display);
+
+    display->_unlock(display);
+}
+#endif
+
+/*
+ * Run a list of drawing operations with one lock and one flush, so the whole
+ * list reaches the panel as a single update.  Operations for primitives that
+ * are not configured are skipped.
+ */
+static void display_draw_list(display_t *display, const display_op_t *ops, int count)
+{
+    display->_lock(display);
+
+    display->hold(display);
+
+    for (const display_op_t *op = ops; op < ops + count; ++op) {
+        switch (op->type) {
+            case display_op_clear:
+                display_clear(display);
+                break;
+
+            case display_op_text:
+                display_render_text(display, op->x, op->y, op->text.text);
+                break;
+
+            case display_op_bitmap:
+                display_render_bitmap(display, op->bitmap.bitmap, op->x, op->y, op->bitmap.width, op->bitmap.height, op->bitmap.method);
+                break;
+
+#if CONFIG_DISPLAY_RECTANGLE_ENABLED
+            case display_op_rectangle:
+                display_render_rectangle(display, op->x, op->y, op->rectangle.width, op->rectangle.height, op->rectangle.flags);
+                break;
+#endif
+
+#if CONFIG_DISPLAY_LINE_ENABLED
+            case display_op_line:
+                display_render_line(display, op->x, op->y, op->line.x2, op->line.y2, op->line.set);
+                break;
+#endif
+
+#if CONFIG_DISPLAY_PIXEL_ENABLED
+            case display_op_pixel:
+                display_render_pixel(display, op->x, op->y, op->pixel.set);
+                break;
+#endif
+
+#if CONFIG_DISPLAY_PROGRESS_BAR_ENABLED
+            case display_op_progress_bar:
+                display_render_progress_bar(display, op->x, op->y, op->progress_bar.width, op->progress_bar.height,
+                                            op->progress_bar.range, op->progress_bar.value, op->progress_bar.text);
+                break;
+#endif
+
+            default:
+                break;
+        }
+    }
+
+    display->show(display);
+
+    display->_unlock(display);
+}
+
+#if CONFIG_DISPLAY_RENDER_QUEUE
+#if (CONFIG_DISPLAY_RENDER_QUEUE_LENGTH & (CONFIG_DISPLAY_RENDER_QUEUE_LENGTH - 1)) != 0
+#error CONFIG_DISPLAY_RENDER_QUEUE_LENGTH must be a power of two
+#endif
 
+#define DISPLAY_RENDER_MASK     (CONFIG_DISPLAY_RENDER_QUEUE_LENGTH - 1)
+
+#define DISPLAY_RENDER_DRAINED  0x01    /* The render task finished a drain */
+#define DISPLAY_RENDER_EXITED   0x02    /* Render task has terminated */
+
+/*
+ * Bounded multi-producer queue.  Each cell's sequence says whose turn it is: a
+ * submitter may claim slot n when it reads n, the render task may draw it when
+ * it reads n + 1, and releasing it sets n + length for the next lap.  Submitters
+ * race only on the head with compare-and-swap, so nobody ever waits on a lock.
+ */
+static bool display_submit(display_t *display, const display_op_t *op)
+{
+    if (display->render_task == NULL) {
+        display->draw_list(display, op, 1);
+        return true;
+    }
 
-#include "display.h"
+    uint32_t pos = __atomic_load_n(&display->render_head, __ATOMIC_RELAXED);
+    display_render_cell_t *cell;
 
-#define TAG "display"
+    while (true) {
+        cell = &display->render_cells[pos & DISPLAY_RENDER_MASK];
 
-static void display_lock(display_t* display)
-{
-    xSemaphoreTakeRecursive(display->mutex, portMAX_DELAY);
-}
+        int32_t diff = (int32_t) (__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) - pos);
 
-static void display_unlock(display_t* display)
-{
-    xSemaphoreGiveRecursive(display->mutex);
-}
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&display->render_head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* Still holding a command from the previous lap: full */
+            __atomic_fetch_add(&display->render_stats.dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        } else {
+            pos = __atomic_load_n(&display->render_head, __ATOMIC_RELAXED);
+        }
+    }
 
-static void display_clear(display_t *display)
-{
-    memset(display->frame_buf, 0, display->frame_len);
-}
+    cell->queued = (uint32_t) esp_timer_get_time();
+    cell->op     = *op;
 
-static void display_hold(display_t *display)
-{
-    display->hold_count++;
-}
+    const char **text = op->type == display_op_text         ? &cell->op.text.text :
+                        op->type == display_op_progress_bar ? &cell->op.progress_bar.text : NULL;
 
-static void display_show(display_t *display)
-{
-    if (display->hold_count > 0) {
-        display->hold_count--;
+    if (text != NULL && *text != NULL) {
+        strncpy(cell->text, *text, sizeof(cell->text) - 1);
+        cell->text[sizeof(cell->text) - 1] = '\0';
+        text_trim_utf8(cell->text);
+        *text = cell->text;
     }
-    if (display->hold_count == 0) {
-        display->_show(display);
+
+    __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+
+    __atomic_fetch_add(&display->render_stats.submitted, 1, __ATOMIC_RELAXED);
+
+    uint32_t depth = pos + 1 - __atomic_load_n(&display->render_tail, __ATOMIC_RELAXED);
+    uint32_t max_depth = __atomic_load_n(&display->render_stats.max_depth, __ATOMIC_RELAXED);
+
+    while (depth > max_depth &&
+           !__atomic_compare_exchange_n(&display->render_stats.max_depth, &max_depth, depth, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
     }
+
+    xTaskNotifyGive(display->render_task);
+
+    return true;
 }
 
 /*
- * Put the bitmap into the frame buffer at x, y.  x,y is the top left corner
- * (x, y, width, height) are the dimensions of the region to be overlayed with the bitmap.
- * Extra space is ignore.  Insufficient space causes truncation.
+ * Draw every ready command under one lock and show once.  At most one queue
+ * length per drain so a steady stream still reaches the panel.
  */
-static void display_draw_bitmap(display_t *display, bitmap_t *bitmap, int x, int y, int width, int height, bitmap_method_t method)
+static void display_render_drain(display_t *display)
 {
-    //static uint8_t masks[] = { 0x00, 0x80, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC, 0xFE, };
-    static uint8_t masks[] = { 0x00, 0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3F, 0x7F, };
-
-    int bitmap_row = 0;
-    int target_row = y;
-
-    int end_x = x + width - 1;
-    int end_y = y + height - 1;
-
-    bool odd = true;
+    uint32_t tail = display->render_tail;
+    uint32_t count = 0;
+    uint32_t oldest = 0;
+    uint32_t queued = 0;
 
     display->_lock(display);
 
     display->hold(display);
 
-    int bitmap_height = bitmap->height;
+    while (count < CONFIG_DISPLAY_RENDER_QUEUE_LENGTH) {
+        display_render_cell_t *cell = &display->render_cells[tail & DISPLAY_RENDER_MASK];
 
-    while (bitmap_height > 0) {
-        /* Compute byte shift and mask */
-        int shift = (bitmap_row + target_row) % 8;  /* Starting row at this y interval */
+        if (__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) != tail + 1) {
+            break;
+        }
 
-ESP_LOGI(TAG, "%s: bitmap_height %d height %d bitmap_row %d col %d target_row %d odd %s shift %d", __func__, bitmap_height, height, bitmap_row, x, target_row, odd ? "ODD left" : "EVEN right", shift);
+        if (count == 0) {
+            oldest = cell->queued;
+        }
+        queued += cell->queued;
+        count++;
 
-        /* Do one row */
-        for (int bx = 0; bx < bitmap->width && (bx + x) < end_x; ++bx) {
-            uint8_t value = bitmap->bits != NULL ? bitmap->bits[bitmap->width * (bitmap_row/8) + bx] : 0xFF;
-            uint8_t mask = ((end_y - target_row + 1) < 8) ? mask = masks[end_y - target_row + 1] : 0xFF;
+        display->draw_list(display, &cell->op, 1);
 
-            if (odd) {
-                value = (value & mask) << shift;
-            } else {
-                value = (value >> shift) & mask;
-            }
+        __atomic_store_n(&cell->sequence, tail + CONFIG_DISPLAY_RENDER_QUEUE_LENGTH, __ATOMIC_RELEASE);
+        tail++;
+    }
 
-            uint8_t *byte = &display->frame_buf[(target_row / 8) * display->width + x + bx];
+    display->show(display);
 
-            if (method == bitmap_method_XOR) {
-                *byte ^= value;
-            } else if (method == bitmap_method_NAND) {
-                *byte &= ~value;
-            } else {
-                *byte |= value;
-            }
-        }
+    /* Only now, so wait_rendered() sees the batch as drawn after its show() */
+    __atomic_store_n(&display->render_tail, tail, __ATOMIC_RELEASE);
 
-        odd = !odd;
+    if (count != 0) {
+        uint32_t now = (uint32_t) esp_timer_get_time();
 
-        /* Move to the  next bitmap row */
-        bitmap_row += (8 - shift);
-        target_row += (8 - shift);
+        /* The batch's latencies add up to count * now less the submit times (wrapping) */
+        display->render_latency_us += count * now - queued;
+        display->render_stats.rendered += count;
+        display->render_stats.batches++;
 
-        /* Remove from the height required */
-        bitmap_height -= (8 - shift);
+        if (now - oldest > display->render_stats.latency_max_us) {
+            display->render_stats.latency_max_us = now - oldest;
+        }
     }
 
-    display->show(display);
-
     display->_unlock(display);
 }
 
-#if CONFIG_DISPLAY_PIXEL_ENABLED
-static void display_draw_pixel(display_t *display, int x, int y, bool set)
+static void display_render_task(void *param)
 {
-    display->_lock(display);
+    display_t *display = (display_t *) param;
 
-    display->hold(display);
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-ESP_LOGI(TAG, "%s: %d,%d %s", __func__, x, y, set ? "DRAW" : "ERASE");
+        /* Commands queued before close are still drawn */
+        while (display->render_tail != __atomic_load_n(&display->render_head, __ATOMIC_ACQUIRE)) {
+            uint32_t tail = display->render_tail;
 
-    if (x >= 0 && x < display->width && y >= 0 && y < display->height) {
-        uint8_t *byte = &display->frame_buf[(y/8) * display->width + x];
+            display_render_drain(display);
 
-        if (set) {
-            *byte |= 1 << (y % 8);
-        } else {
-            *byte &= ~(1 << (y % 8));
+            xEventGroupSetBits(display->render_events, DISPLAY_RENDER_DRAINED);
+
+            /* Next slot claimed but not yet filled; its submitter notifies again */
+            if (display->render_tail == tail) {
+                break;
+            }
+        }
+
+        if (__atomic_load_n(&display->render_exit, __ATOMIC_ACQUIRE)) {
+            break;
         }
     }
 
-    display->show(display);
+    xEventGroupSetBits(display->render_events, DISPLAY_RENDER_EXITED);
 
-    display->_unlock(display);
+    /* Close deletes the task once it is parked, as for the flush task */
+    vTaskSuspend(NULL);
 }
-#endif
 
-#if CONFIG_DISPLAY_LINE_ENABLED
-static void display_draw_line(display_t *display, int x1, int y1, int x2, int y2, bool set)
+/*
+ * Wait until the render task has drawn every command submitted before the
+ * call, then until that has been flushed.  Returns false on timeout.
+ */
+static bool display_wait_rendered(display_t *display, TickType_t timeout)
 {
-ESP_LOGI(TAG, "%s: %d,%d to %d,%d  set %s", __func__, x1, y1, x2, y2, set ? "DRAW" : "ERASE");
-
-    display->_lock(display);
+    if (display->render_task != NULL) {
+        uint32_t target = __atomic_load_n(&display->render_head, __ATOMIC_ACQUIRE);
+        TickType_t start = xTaskGetTickCount();
 
-    display->hold(display);
+        while (true) {
+            xEventGroupClearBits(display->render_events, DISPLAY_RENDER_DRAINED);
 
-    int dx =  abs(x2-x1);
-    int sx = x1<x2 ? 1 : -1;
-    int dy = -abs(y2-y1);
-    int sy = y1<y2 ? 1 : -1;
-    int err = dx+dy;
+            if ((int32_t) (__atomic_load_n(&display->render_tail, __ATOMIC_ACQUIRE) - target) >= 0) {
+                break;
+            }
 
-    do {
-        display_draw_pixel(display, x1, y1, set);
+            TickType_t elapsed = xTaskGetTickCount() - start;
 
-        if (x1 != x2 || y1 != y2) {
-            int e2 = 2*err;
-            if (e2 >= dy) {
-                err += dy;
-                x1 += sx;
+            if (timeout != portMAX_DELAY && elapsed >= timeout) {
+                return false;
             }
 
-            if (e2 <= dx) {
-                err += dx;
-                y1 += sy;
-            }
+            xEventGroupWaitBits(display->render_events, DISPLAY_RENDER_DRAINED, pdFALSE, pdTRUE,
+                                timeout == portMAX_DELAY ? portMAX_DELAY : timeout - elapsed);
         }
-    } while (x1 != x2 || y1 != y2);
-
-    display->show(display);
+    }
 
-    display->_unlock(display);
+    return display->wait_flushed(display, timeout);
 }
-#endif
 
-#if CONFIG_DISPLAY_RECTANGLE_ENABLED
-static void display_draw_rectangle(display_t *display, int x, int y, int width, int height, draw_flags_t flags)
+static void display_get_render_stats(display_t *display, display_render_stats_t *stats)
 {
-ESP_LOGI(TAG, "%s: x %d y %d width %d height %d flags %02x", __func__, x, y, width, height, flags);
+    display->_lock(display);
 
-    int x1 = x;
-    int x2 = x + width - 1;
-    int y1 = y;
-    int y2 = y + height - 1;
+    stats->rendered       = display->render_stats.rendered;
+    stats->batches        = display->render_stats.batches;
+    stats->latency_max_us = display->render_stats.latency_max_us;
+    stats->latency_avg_us = 0;
 
-    if (x1 < 0) {
-        x1 = 0;
-    } else if (x1 >= display->width) {
-        x1 = display->width - 1;
-    }
+    /* Updated by submitters without the lock */
+    stats->submitted = __atomic_load_n(&display->render_stats.submitted, __ATOMIC_RELAXED);
+    stats->dropped   = __atomic_load_n(&display->render_stats.dropped, __ATOMIC_RELAXED);
+    stats->max_depth = __atomic_load_n(&display->render_stats.max_depth, __ATOMIC_RELAXED);
+    stats->depth = __atomic_load_n(&display->render_head, __ATOMIC_RELAXED) - __atomic_load_n(&display->render_tail, __ATOMIC_RELAXED);
 
-    if (x2 < 0) {
-        x2 = 0;
-    } else if (x2 >= display->width) {
-        x2 = display->width - 1;
+    if (stats->rendered != 0) {
+        stats->latency_avg_us = display->render_latency_us / stats->rendered;
     }
 
-    if (y1 < 0) {
-        y1 = 0;
-    } else if (y1 >= display->height) {
-        y1 = display->height - 1;
-    }
+    display->_unlock(display);
+}
 
-    if (y2 < 0) {
-        y2 = 0;
-    } else if (y2 >= display->height) {
-        y2 = display->height - 1;
+/* Queue cells, event group and task are supplied by the caller */
+static void display_init_render(display_t *display)
+{
+    for (uint32_t index = 0; index < CONFIG_DISPLAY_RENDER_QUEUE_LENGTH; ++index) {
+        display->render_cells[index].sequence = index;
     }
+}
+#endif /* CONFIG_DISPLAY_RENDER_QUEUE */
 
+#if CONFIG_DISPLAY_CONSOLE_ENABLED
+/*
+ * Start or leave console mode; either way the screen is cleared and the start
+ * line reset.
+ */
+static void display_console_enable(display_t *display, bool enable)
+{
     display->_lock(display);
-    
+
     display->hold(display);
 
-    if (flags & draw_flag_border) {
-        display_draw_line(display, x1, y1, x2, y1, !(flags & draw_flag_clear));
-        display_draw_line(display, x2, y1, x2, y2, !(flags & draw_flag_clear));
-        display_draw_line(display, x2, y2, x1, y2, !(flags & draw_flag_clear));
-        display_draw_line(display, x1, y2, x1, y1, !(flags & draw_flag_clear));
-        x1++;
-        y1++;
-        x2--;
-        y2--;
-    }
-        
-//    if (flags & (draw_flag_fill | draw_flag_clear)) {
-//        for (int y = y1; y <= y2; ++y) {
-//            display_draw_line(display, x1, y, x2, y, !(flags & draw_flag_clear));
-//        } 
-//    }
+    display->clear(display);
 
-    if (flags & (draw_flag_fill | draw_flag_clear)) {
-        /* When  the bits pointer is 0, the bitmap is full of ones */
-        bitmap_t bitmap = {
-            .bits = NULL,
-            .width =  width,
-            .height = height,
-        };
-
-        bitmap_method_t method = (flags & draw_flag_clear) ? bitmap_method_NAND : bitmap_method_OR;
-
-        display->draw_bitmap(display, &bitmap, x, y, width, height, method);
-//        int y = y1;
-//        while (y <= y2) {
-//            int x = x1;
-//
-//            while (x <= x2) {
-//               display->draw_bitmap(display, &bitmap, x, y, width - (x - x1), height - (y - y1), method);
-//               x += bitmap.width;
-//            } 
-//
-//            y += bitmap.height;
-//        } 
-    }
+    display->console       = enable;
+    display->console_lines = 0;
+    display->start_line    = 0;
 
     display->show(display);
 
     display->_unlock(display);
 }
-#endif
 
 /*
- * Draw text in rectangle at x, y
+ * Page for the next console line.  Until the screen is full lines fill it from
+ * the top; after that the oldest line's page is reused and the start line moves
+ * down a page so it appears at the bottom.  The start line wraps at 64 rows, so
+ * other panels move the frame buffer up a page instead.
  */
-static void display_draw_text(display_t *display, int x, int y, const char* text)
+static int display_console_next_page(display_t *display)
 {
-    display->_lock(display);
+    if (display->console_lines < display->pages) {
+        return display->console_lines++;
+    }
 
-    display->hold(display);
+    if (display->height == 64) {
+        int page = display->start_line / 8;
 
-    int textx = x;
-    int texty = y;
+        display->start_line = ((page + 1) % display->pages) * 8;
 
-    while (*text != '\0' && textx < display->width - 1) {
-        bitmap_t bitmap;
+        return page;
+    }
 
-        if (char_to_bitmap(&bitmap, display->font, *text)) {
+    memmove(display->frame_buf, display->frame_buf + display->width, display->frame_len - display->width);
 
-            if (textx + bitmap.width >= display->width || *text == '\n') {
-                /* Advance a line */
-                texty += display->font_height;
+    display_mark_dirty(display, 0, 0, display->width, display->height);
 
-                /* Reset X */
-                textx = x;
+    return display->pages - 1;
+}
 
-                if (*text == '\n') {
-                    ++text;
-                }
-            } else if (texty + bitmap.height <= display->height) {
-                display_draw_bitmap(display, &bitmap, textx, texty, bitmap.width, bitmap.height, bitmap_method_XOR);
-                textx += bitmap.width;
-                ++text;
-            }
-        }
-    }
+/*
+ * Write text to the console.  Each line (split at newlines and wrapped at the
+ * screen edge) replaces a whole page, so one new line sends one page.
+ */
+static void display_console_write(display_t *display, const char *text)
+{
+    display->_lock(display);
 
-    display->show(display);
+    display->hold(display);
 
-    display->_unlock(display);
-}
+    do {
+        int page = display_console_next_page(display);
 
-#if CONFIG_DISPLAY_PROGRESS_BAR_ENABLED
-void display_draw_progress_bar(display_t *display, int x, int y, int width, int height, int range, int value, const char* text)
-{
-    /* Draw surrounding border */
-    display->draw_rectangle(display, x, y, width, height, draw_flag_border);
+        memset(&display->frame_buf[page * display->width], 0, display->width);
+        display_mark_dirty(display, 0, page * 8, display->width, 8);
 
-    /* Make smaller rectangle for the moving bar */
-    x += 1;
-    y += 1;
-    width -= 2;
-    height -= 2;
+        int x = 0;
 
-    int bar = ((width - 1) * value) / range;
+        while (*text != '\0' && *text != '\n') {
+            const char *next = text;
+            int ch = text_next_char(&next);
+            bitmap_t bitmap;
 
-    display->hold(display);
+            if (char_to_bitmap(&bitmap, display->font, ch)) {
+                if (x + bitmap.width > display->width && x != 0) {
+                    /* Wrap */
+                    break;
+                }
 
-    /* Paint the Progress part */
-    display->draw_rectangle(display, x, y, bar, height, draw_flag_fill);
+                display_render_glyph(display, display->font, ch, &bitmap, x, page * 8, 8, bitmap_method_OR);
+                x += bitmap.width;
+            }
 
-    /* Paint the non-progress part */
-    if (range != value) {
-        display->draw_rectangle(display, x + bar, y, width - bar, height, draw_flag_clear);
-    }
+            text = next;
+        }
 
-    if (text != NULL) {
-        int cwidth, cheight;
-        text_metrics(display->font, text, &cwidth, &cheight);
-        display->draw_text(display, x + width/2 - cwidth/2, y + height/2 - cheight/2, text);
-    }
+        if (*text == '\n') {
+            ++text;
+        }
+    } while (*text != '\0');
 
     display->show(display);
+
+    display->_unlock(display);
 }
-#endif
+#endif /* CONFIG_DISPLAY_CONSOLE_ENABLED */
 
 static void display_set_font(display_t *display, const font_t* font)
 {
@@ -356,36 +1779,101 @@ static const font_t *display_get_font(display_t *display)
 
 static void display_close(display_t* display)
 {
+#if CONFIG_DISPLAY_RENDER_QUEUE
+    if (display->render_task != NULL) {
+        __atomic_store_n(&display->render_exit, true, __ATOMIC_RELEASE);
+        xTaskNotifyGive(display->render_task);
+
+        xEventGroupWaitBits(display->render_events, DISPLAY_RENDER_EXITED, pdFALSE, pdTRUE, portMAX_DELAY);
+
+        while (eTaskGetState(display->render_task) != eSuspended) {
+            vTaskDelay(1);
+        }
+        vTaskDelete(display->render_task);
+
+        vEventGroupDelete(display->render_events);
+
+        if (!display->is_static) {
+            free((void*) display->render_cells);
+        }
+    }
+#endif
+
+#if CONFIG_DISPLAY_ASYNC_FLUSH
+    if (display->flush_task != NULL) {
+        __atomic_store_n(&display->flush_exit, true, __ATOMIC_RELEASE);
+        xTaskNotifyGive(display->flush_task);
+
+        xEventGroupWaitBits(display->flush_events, DISPLAY_FLUSH_EXITED, pdFALSE, pdTRUE, portMAX_DELAY);
+
+        while (eTaskGetState(display->flush_task) != eSuspended) {
+            vTaskDelay(1);
+        }
+        vTaskDelete(display->flush_task);
+
+        vEventGroupDelete(display->flush_events);
+
+        if (!display->is_static) {
+            free((void*) display->show_buf);
+            free((void*) display->show_dirty);
+        }
+    }
+#endif
+
     vSemaphoreDelete(display->mutex); 
 
-    free((void*) display);
+    if (!display->is_static) {
+        free((void*) display->frame_buf);
+        free((void*) display->dirty);
+
+        free((void*) display);
+    }
 }
 
+/*
+ * Set up a display whose frame buffer and dirty ranges have been supplied.
+ */
 static void display_init(display_t* display, int width, int height, uint8_t flags)
 {
-    /* Create the frame buffer */
-    display->frame_len            = (width * height) / 8;
-    display->frame_buf            = (uint8_t *) malloc(display->frame_len);
+    display->frame_len            = DISPLAY_FRAME_LEN(width, height);
 
 ESP_LOGI(TAG, "%s: frame_buf is %p", __func__, display->frame_buf);
 
     memset(display->frame_buf, 0, display->frame_len);
 
+    /* Nothing has been drawn yet; every page starts clean */
+    display->pages                = DISPLAY_PAGES(height);
+
+    for (int page = 0; page < display->pages; ++page) {
+        display->dirty[page].x1   = width;
+        display->dirty[page].x2   = -1;
+    }
+
     display->width                = width;
     display->height               = height;
     display->flags                = flags;
 
+    /* Transmit straight from the drawing buffer unless flushing asynchronously */
+    display->show_buf             = display->frame_buf;
+    display->show_dirty           = display->dirty;
+
     display->_lock                = display_lock;
     display->_unlock              = display_unlock;
+    display->_mark_dirty          = display_mark_dirty;
 
     display->hold                 = display_hold;
     display->show                 = display_show;
+    display->wait_flushed         = display_wait_flushed;
     display->close                = display_close;
     display->set_font             = display_set_font;
     display->get_font             = display_get_font;
     display->clear                = display_clear;
     display->draw_text            = display_draw_text;
+    display->draw_textf           = display_draw_textf;
+    display->draw_field           = display_draw_field;
+    display->draw_layout          = display_draw_layout;
     display->draw_bitmap          = display_draw_bitmap;
+    display->draw_list            = display_draw_list;
 
     /* Optional items below */
 
@@ -400,10 +1888,33 @@ ESP_LOGI(TAG, "%s: frame_buf is %p", __func__, display->frame_buf);
 #endif
 #if CONFIG_DISPLAY_PROGRESS_BAR_ENABLED
     display->draw_progress_bar    = display_draw_progress_bar;
+    display->update_progress_bar  = display_update_progress_bar;
 #endif
+#if CONFIG_DISPLAY_CONSOLE_ENABLED
+    display->console_enable       = display_console_enable;
+    display->console_write        = display_console_write;
+#endif
+#if CONFIG_DISPLAY_RENDER_QUEUE
+    display->submit               = display_submit;
+    display->wait_rendered        = display_wait_rendered;
+    display->get_render_stats     = display_get_render_stats;
+#endif
+
+}
 
-    display->mutex = xSemaphoreCreateRecursiveMutex();
+#if CONFIG_DISPLAY_ASYNC_FLUSH
+/*
+ * Second buffer the flush task transmits from while drawing continues.  The
+ * buffers and the event group are set up by the caller.
+ */
+static void display_init_async(display_t* display)
+{
+    memset(display->show_buf, 0, display->frame_len);
+    memcpy(display->show_dirty, display->dirty, display->pages * sizeof(display_dirty_t));
+
+    xEventGroupSetBits(display->flush_events, DISPLAY_FLUSH_IDLE);
 }
+#endif
 
 display_t *display_create(int width, int height, uint8_t flags)
 {
@@ -415,9 +1926,101 @@ ESP_LOGI(TAG, "%s: display is %p", __func__, display);
 
     if (display != NULL) {
         memset(display, 0, sizeof(*display));
+
+        display->frame_buf = (uint8_t *) malloc(DISPLAY_FRAME_LEN(width, height));
+        display->dirty     = (display_dirty_t *) malloc(DISPLAY_PAGES(height) * sizeof(display_dirty_t));
+
         display_init(display, width, height, flags);
+
+        display->mutex = xSemaphoreCreateRecursiveMutex();
+
+#if CONFIG_DISPLAY_ASYNC_FLUSH
+        if (flags & DISPLAY_FLAGS_ASYNC) {
+            display->show_buf     = (uint8_t *) malloc(display->frame_len);
+            display->show_dirty   = (display_dirty_t *) malloc(display->pages * sizeof(display_dirty_t));
+            display->flush_events = xEventGroupCreate();
+
+            display_init_async(display);
+
+            xTaskCreate(display_flush_task, "display_flush", CONFIG_DISPLAY_FLUSH_TASK_STACK, display, CONFIG_DISPLAY_FLUSH_TASK_PRIORITY, &display->flush_task);
+        }
+#endif
+
+#if CONFIG_DISPLAY_RENDER_QUEUE
+        if (flags & DISPLAY_FLAGS_RENDER) {
+            display->render_cells  = (display_render_cell_t *) malloc(CONFIG_DISPLAY_RENDER_QUEUE_LENGTH * sizeof(display_render_cell_t));
+            display->render_events = xEventGroupCreate();
+
+            display_init_render(display);
+
+            xTaskCreate(display_render_task, "display_render", CONFIG_DISPLAY_RENDER_TASK_STACK, display, CONFIG_DISPLAY_RENDER_TASK_PRIORITY, &display->render_task);
+        }
+#endif
+    }
+
+ESP_LOGI(TAG, "%s: returning %p", __func__, display);
+
+    return display;
+}
+
+/* Take the next aligned piece of a static buffer */
+static void *display_static_carve(uint8_t **next, size_t len)
+{
+    void *piece = *next;
+
+    *next += DISPLAY_STATIC_ALIGN(len);
+
+    return piece;
+}
+
+display_t *display_create_static(display_static_t *storage, void *buffer, size_t size, int width, int height, uint8_t flags)
+{
+ESP_LOGI(TAG, "%s: storage %p buffer %p size %d, %d,%d flags %02x", __func__, storage, buffer, (int) size, width, height, flags);
+
+    if (size < DISPLAY_STATIC_BUFFER_SIZE(width, height)) {
+        ESP_LOGE(TAG, "%s: buffer needs %d bytes", __func__, (int) DISPLAY_STATIC_BUFFER_SIZE(width, height));
+        return NULL;
     }
 
+    uint8_t *next = (uint8_t *) DISPLAY_STATIC_ALIGN((uintptr_t) buffer);
+
+    display_t *display = &storage->display;
+
+    memset(display, 0, sizeof(*display));
+
+    display->is_static = true;
+    display->frame_buf = (uint8_t *) display_static_carve(&next, DISPLAY_FRAME_LEN(width, height));
+    display->dirty     = (display_dirty_t *) display_static_carve(&next, DISPLAY_PAGES(height) * sizeof(display_dirty_t));
+
+    display_init(display, width, height, flags);
+
+    display->mutex = xSemaphoreCreateRecursiveMutexStatic(&storage->mutex);
+
+#if CONFIG_DISPLAY_ASYNC_FLUSH
+    if (flags & DISPLAY_FLAGS_ASYNC) {
+        display->show_buf     = (uint8_t *) display_static_carve(&next, display->frame_len);
+        display->show_dirty   = (display_dirty_t *) display_static_carve(&next, display->pages * sizeof(display_dirty_t));
+        display->flush_events = xEventGroupCreateStatic(&storage->flush_events);
+
+        display_init_async(display);
+
+        display->flush_task = xTaskCreateStatic(display_flush_task, "display_flush", CONFIG_DISPLAY_FLUSH_TASK_STACK, display, CONFIG_DISPLAY_FLUSH_TASK_PRIORITY,
+                                                storage->flush_stack, &storage->flush_task);
+    }
+#endif
+
+#if CONFIG_DISPLAY_RENDER_QUEUE
+    if (flags & DISPLAY_FLAGS_RENDER) {
+        display->render_cells  = storage->render_cells;
+        display->render_events = xEventGroupCreateStatic(&storage->render_events);
+
+        display_init_render(display);
+
+        display->render_task = xTaskCreateStatic(display_render_task, "display_render", CONFIG_DISPLAY_RENDER_TASK_STACK, display, CONFIG_DISPLAY_RENDER_TASK_PRIORITY,
+                                                 storage->render_stack, &storage->render_task);
+    }
+#endif
+
 ESP_LOGI(TAG, "%s: returning %p", __func__, display);
 
     return display;
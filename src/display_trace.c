@@ -0,0 +1,89 @@
+/*
+ * display_trace.c
+ *
+ * Fixed-size binary trace ring for the display paths.
+ */
+#include "sdkconfig.h" // generated by "make menuconfig"
+
+#if CONFIG_SSD1306_I2C_ENABLED && CONFIG_DISPLAY_TRACE
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_timer.h"
+
+#include "display_trace.h"
+
+static display_trace_entry_t trace_ring[CONFIG_DISPLAY_TRACE_ENTRIES];
+
+/* Total entries ever recorded; the slot is this modulo the ring size */
+static uint32_t trace_head;
+static uint32_t trace_tail;
+
+static const char *trace_names[display_trace_op_max] = {
+    [display_trace_op_clear]            = "clear",
+    [display_trace_op_show]             = "show",
+    [display_trace_op_flush]            = "flush",
+    [display_trace_op_draw_text]        = "draw_text",
+    [display_trace_op_draw_bitmap]      = "draw_bitmap",
+    [display_trace_op_draw_pixel]       = "draw_pixel",
+    [display_trace_op_draw_line]        = "draw_line",
+    [display_trace_op_draw_rectangle]   = "draw_rectangle",
+    [display_trace_op_draw_progress]    = "draw_progress_bar",
+    [display_trace_op_contrast]         = "contrast",
+    [display_trace_op_enable]           = "enable",
+    [display_trace_op_scroll]           = "scroll",
+};
+
+void display_trace_record(display_trace_op_t op, int a0, int a1, int a2, int a3)
+{
+    uint32_t index = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+
+    display_trace_entry_t *entry = &trace_ring[index % CONFIG_DISPLAY_TRACE_ENTRIES];
+
+    entry->timestamp = (uint32_t) esp_timer_get_time();
+    entry->op        = op;
+    entry->args[0]   = a0;
+    entry->args[1]   = a1;
+    entry->args[2]   = a2;
+    entry->args[3]   = a3;
+}
+
+int display_trace_read(display_trace_entry_t *entries, int max)
+{
+    uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_RELAXED);
+    uint32_t tail = trace_tail;
+
+    /* Older entries have been overwritten */
+    if (head - tail > CONFIG_DISPLAY_TRACE_ENTRIES) {
+        tail = head - CONFIG_DISPLAY_TRACE_ENTRIES;
+    }
+
+    int count = 0;
+
+    while (tail != head && count < max) {
+        entries[count++] = trace_ring[tail++ % CONFIG_DISPLAY_TRACE_ENTRIES];
+    }
+
+    return count;
+}
+
+void display_trace_dump(void)
+{
+    uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_RELAXED);
+
+    if (head - trace_tail > CONFIG_DISPLAY_TRACE_ENTRIES) {
+        printf("display trace: %u entries lost\n", (unsigned) (head - trace_tail - CONFIG_DISPLAY_TRACE_ENTRIES));
+        trace_tail = head - CONFIG_DISPLAY_TRACE_ENTRIES;
+    }
+
+    while (trace_tail != head) {
+        display_trace_entry_t *entry = &trace_ring[trace_tail++ % CONFIG_DISPLAY_TRACE_ENTRIES];
+
+        printf("%10u %-18s %6d %6d %6d %6d\n", (unsigned) entry->timestamp,
+               entry->op < display_trace_op_max ? trace_names[entry->op] : "?",
+               entry->args[0], entry->args[1], entry->args[2], entry->args[3]);
+    }
+}
+
+#endif /* CONFIG_SSD1306_I2C_ENABLED && CONFIG_DISPLAY_TRACE */
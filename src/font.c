@@ -1,54 +1,188 @@
 /*
  * Return address of the row of font glyph bytes
  */
+#include <string.h>
 #include <sys/types.h>
 #include "font.h"
 
-uint8_t *char_to_bitmap(bitmap_t *bitmap, const font_t *font, int ch)
+/* Glyph number of ch, or -1 when the font has none */
+static int font_glyph_number(const font_t *font, int ch)
 {
-    uint8_t *glyph = NULL;
+    if (ch < font->first_ch || ch > font->last_ch) {
+        return -1;
+    }
+
+    if ((font->flags & font_flag_sparse) == 0) {
+        return ch - font->first_ch;
+    }
 
-    if (ch >= font->first_ch && ch <= font->last_ch) {
-        if ((font->flags & font_flag_pitch) == font_flag_fixed) {
-            bitmap->bits = (uint8_t*) font->base + ((ch - font->first_ch) * font->width);
+    int block = font->map_blocks[ch / FONT_MAP_BLOCK - font->first_ch / FONT_MAP_BLOCK];
 
-            /* These need to change for variable pitch fonts */
-            bitmap->width = font->width;
-            bitmap->height = font->height;
+    if (block == 0) {
+        return -1;
+    }
+
+    int glyph = font->map[block - 1][ch % FONT_MAP_BLOCK];
+
+    return glyph != FONT_MAP_NONE ? glyph : -1;
+}
 
-            /* Return the bit array for the glyph */
-            glyph = bitmap->bits;
+uint8_t *font_char(const font_t *font, int ch, int *pwidth, int *pheight)
+{
+    uint8_t *glyph = NULL;
+    int width = 0;
+    int number = font_glyph_number(font, ch);
+
+    if (number >= 0) {
+        if ((font->flags & font_flag_pitch) == font_flag_fixed && font->format == bitmap_format_raw) {
+            glyph = font->base + number * font->width * ((font->height + 7) / 8);
+            width = font->width;
         } else {
-            /* Need to do something for variable pitch fonts */
+            glyph = font->base + font->glyphs[number].offset;
+            width = font->glyphs[number].width;
         }
     }
-        
+
+    if (pwidth != NULL) {
+        *pwidth = width;
+    }
+
+    if (pheight != NULL) {
+        *pheight = glyph != NULL ? font->height : 0;
+    }
+
     return glyph;
 }
 
-void text_metrics(const font_t *font, const char* text, int *pwidth, int *pheight)
+uint8_t *char_to_bitmap(bitmap_t *bitmap, const font_t *font, int ch)
 {
-    if (pwidth != NULL) {
-        *pwidth = 0;
+    uint8_t *glyph = font_char(font, ch, &bitmap->width, &bitmap->height);
+
+    if (glyph == NULL && font->replacement_ch != 0) {
+        glyph = font_char(font, font->replacement_ch, &bitmap->width, &bitmap->height);
     }
 
-    if (pheight != NULL) {
-        *pheight = 0;
+    /* Return the bit array for the glyph */
+    bitmap->bits   = glyph;
+    bitmap->format = font->format;
+
+    return glyph;
+}
+
+int text_next_char(const char **ptext)
+{
+    const uint8_t *text = (const uint8_t *) *ptext;
+    int ch = text[0];
+    int length;
+    int min;
+
+    if (ch < 0x80) {
+        *ptext += ch != 0 ? 1 : 0;
+        return ch;
+    } else if ((ch & 0xE0) == 0xC0) {
+        length = 2;
+        min = 0x80;
+        ch &= 0x1F;
+    } else if ((ch & 0xF0) == 0xE0) {
+        length = 3;
+        min = 0x800;
+        ch &= 0x0F;
+    } else if ((ch & 0xF8) == 0xF0) {
+        length = 4;
+        min = 0x10000;
+        ch &= 0x07;
+    } else {
+        /* Stray continuation byte or invalid lead */
+        *ptext += 1;
+        return FONT_REPLACEMENT_CH;
+    }
+
+    for (int index = 1; index < length; ++index) {
+        /* Also stops at the NUL of a cut off sequence */
+        if ((text[index] & 0xC0) != 0x80) {
+            *ptext += index;
+            return FONT_REPLACEMENT_CH;
+        }
+        ch = (ch << 6) | (text[index] & 0x3F);
     }
 
+    *ptext += length;
+
+    /* Overlong forms, surrogates and values past Unicode */
+    if (ch < min || (ch >= 0xD800 && ch <= 0xDFFF) || ch > 0x10FFFF) {
+        return FONT_REPLACEMENT_CH;
+    }
+
+    return ch;
+}
+
+void text_trim_utf8(char *text)
+{
+    size_t length = strlen(text);
+    size_t start = length;
+
+    /* Back over up to three continuation bytes to the sequence's lead byte */
+    while (start > 0 && length - start < 3 && ((uint8_t) text[start - 1] & 0xC0) == 0x80) {
+        --start;
+    }
+
+    if (start == 0) {
+        return;
+    }
+
+    uint8_t lead = text[start - 1];
+    size_t need = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+
+    if (length - (start - 1) < need) {
+        text[start - 1] = '\0';
+    }
+}
+
+/*
+ * Size of UTF-8 text: the width of its widest line and the height from the top
+ * of the first line to the bottom of the tallest glyph on the last, lines
+ * being a font height apart.  Missing characters measure as the replacement
+ * glyph, or take no room without one, the same as when drawn.
+ */
+void text_metrics(const font_t *font, const char* text, int *pwidth, int *pheight)
+{
+    int width = 0;
+    int height = 0;
+    int line_width = 0;
+    int line_height = 0;
+
     while (*text != 0) {
-        /* Need to change for variable pitch fonts */
-        int cwidth = font->width;
-        int cheight = font->height;
+        int cwidth, cheight;
+        int ch = text_next_char(&text);
+
+        if (ch == '\n') {
+            height += font->height;
+            line_width = 0;
+            line_height = 0;
+            continue;
+        }
+
+        /* Straight from the index, without building a bitmap */
+        if (font_char(font, ch, &cwidth, &cheight) == NULL && font->replacement_ch != 0) {
+            font_char(font, font->replacement_ch, &cwidth, &cheight);
+        }
 
-        if (pwidth != NULL) {
-            *pwidth += cwidth;
+        line_width += cwidth;
+
+        if (line_width > width) {
+            width = line_width;
         }
 
-        if (pheight != NULL && cheight > *pheight) {
-            *pheight = cheight;
+        if (cheight > line_height) {
+            line_height = cheight;
         }
-        ++text;
     }
-}
 
+    if (pwidth != NULL) {
+        *pwidth = width;
+    }
+
+    if (pheight != NULL) {
+        *pheight = height + line_height;
+    }
+}
@@ -41,6 +41,13 @@
 	}
 */
 
+/*
+   After the basic latin rows come a few Latin-1 characters (degree, micro,
+   signs and the common accented letters), drawn in the same style.  The font
+   is sparse: font8x8_basic_map gives the table row of each character.  U+007F
+   is drawn as a box and stands in for characters the font lacks.
+*/
+
 static uint8_t font8x8_basic_tr_table[][8] = {
     { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // U+0020 (space)
     { 0x00, 0x00, 0x06, 0x5F, 0x5F, 0x06, 0x00, 0x00 },   // U+0021 (!)
@@ -137,17 +144,90 @@ static uint8_t font8x8_basic_tr_table[][8] = {
     { 0x00, 0x00, 0x00, 0x77, 0x77, 0x00, 0x00, 0x00 },   // U+007C (|)
     { 0x41, 0x41, 0x77, 0x3E, 0x08, 0x08, 0x00, 0x00 },   // U+007D (})
     { 0x02, 0x03, 0x01, 0x03, 0x02, 0x03, 0x01, 0x00 },   // U+007E (~)
-    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }    // U+007F
+    { 0x7F, 0x41, 0x41, 0x41, 0x41, 0x7F, 0x00, 0x00 },   // U+007F (replacement)
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // U+00A0 (nbsp)
+    { 0x02, 0x07, 0x05, 0x07, 0x02, 0x00, 0x00, 0x00 },   // U+00B0 (°)
+    { 0x44, 0x44, 0x5F, 0x5F, 0x44, 0x44, 0x00, 0x00 },   // U+00B1 (±)
+    { 0x00, 0x19, 0x1D, 0x17, 0x12, 0x00, 0x00, 0x00 },   // U+00B2 (²)
+    { 0x11, 0x15, 0x1F, 0x0B, 0x00, 0x00, 0x00, 0x00 },   // U+00B3 (³)
+    { 0xFC, 0xFC, 0x40, 0x40, 0x7C, 0x3C, 0x40, 0x00 },   // U+00B5 (µ)
+    { 0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00, 0x00 },   // U+00B7 (·)
+    { 0x79, 0x7D, 0x16, 0x16, 0x7D, 0x79, 0x00, 0x00 },   // U+00C4 (Ä)
+    { 0x19, 0x3D, 0x66, 0x42, 0x66, 0x3D, 0x19, 0x00 },   // U+00D6 (Ö)
+    { 0x7D, 0x7D, 0x40, 0x40, 0x7D, 0x7D, 0x00, 0x00 },   // U+00DC (Ü)
+    { 0xFE, 0xFF, 0x09, 0x5F, 0x76, 0x20, 0x00, 0x00 },   // U+00DF (ß)
+    { 0x20, 0x75, 0x57, 0x56, 0x3C, 0x78, 0x40, 0x00 },   // U+00E0 (à)
+    { 0x20, 0x74, 0x56, 0x57, 0x3D, 0x78, 0x40, 0x00 },   // U+00E1 (á)
+    { 0x20, 0x76, 0x55, 0x55, 0x3E, 0x78, 0x40, 0x00 },   // U+00E2 (â)
+    { 0x21, 0x75, 0x54, 0x54, 0x3D, 0x79, 0x40, 0x00 },   // U+00E4 (ä)
+    { 0x38, 0x7C, 0xC4, 0xC4, 0x6C, 0x28, 0x00, 0x00 },   // U+00E7 (ç)
+    { 0x38, 0x7D, 0x57, 0x56, 0x5C, 0x18, 0x00, 0x00 },   // U+00E8 (è)
+    { 0x38, 0x7C, 0x56, 0x57, 0x5D, 0x18, 0x00, 0x00 },   // U+00E9 (é)
+    { 0x38, 0x7E, 0x55, 0x55, 0x5E, 0x18, 0x00, 0x00 },   // U+00EA (ê)
+    { 0x39, 0x7D, 0x54, 0x54, 0x5D, 0x19, 0x00, 0x00 },   // U+00EB (ë)
+    { 0x00, 0x45, 0x7F, 0x7E, 0x40, 0x00, 0x00, 0x00 },   // U+00EC (ì)
+    { 0x00, 0x44, 0x7E, 0x7F, 0x41, 0x00, 0x00, 0x00 },   // U+00ED (í)
+    { 0x00, 0x46, 0x7D, 0x7D, 0x42, 0x00, 0x00, 0x00 },   // U+00EE (î)
+    { 0x01, 0x45, 0x7C, 0x7C, 0x41, 0x01, 0x00, 0x00 },   // U+00EF (ï)
+    { 0x7E, 0x7D, 0x07, 0x06, 0x7D, 0x78, 0x00, 0x00 },   // U+00F1 (ñ)
+    { 0x38, 0x7D, 0x47, 0x46, 0x7C, 0x38, 0x00, 0x00 },   // U+00F2 (ò)
+    { 0x38, 0x7C, 0x46, 0x47, 0x7D, 0x38, 0x00, 0x00 },   // U+00F3 (ó)
+    { 0x38, 0x7E, 0x45, 0x45, 0x7E, 0x38, 0x00, 0x00 },   // U+00F4 (ô)
+    { 0x39, 0x7D, 0x44, 0x44, 0x7D, 0x39, 0x00, 0x00 },   // U+00F6 (ö)
+    { 0x3C, 0x7D, 0x43, 0x42, 0x3C, 0x7C, 0x40, 0x00 },   // U+00F9 (ù)
+    { 0x3C, 0x7C, 0x42, 0x43, 0x3D, 0x7C, 0x40, 0x00 },   // U+00FA (ú)
+    { 0x3C, 0x7E, 0x41, 0x41, 0x3E, 0x7C, 0x40, 0x00 },   // U+00FB (û)
+    { 0x3D, 0x7D, 0x40, 0x40, 0x3D, 0x7D, 0x40, 0x00 }    // U+00FC (ü)
 };
 
+#define NONE FONT_MAP_NONE
+
+/* Glyph number (table row) of each character, 32 a row */
+static const uint16_t font8x8_basic_map[][FONT_MAP_BLOCK] = {
+    /* U+0020 - U+003F */ {
+           0,    1,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,   12,   13,   14,   15,
+          16,   17,   18,   19,   20,   21,   22,   23,   24,   25,   26,   27,   28,   29,   30,   31,
+    },
+    /* U+0040 - U+005F */ {
+          32,   33,   34,   35,   36,   37,   38,   39,   40,   41,   42,   43,   44,   45,   46,   47,
+          48,   49,   50,   51,   52,   53,   54,   55,   56,   57,   58,   59,   60,   61,   62,   63,
+    },
+    /* U+0060 - U+007F */ {
+          64,   65,   66,   67,   68,   69,   70,   71,   72,   73,   74,   75,   76,   77,   78,   79,
+          80,   81,   82,   83,   84,   85,   86,   87,   88,   89,   90,   91,   92,   93,   94,   95,
+    },
+    /* U+00A0 - U+00BF */ {
+          96, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE,
+          97,   98,   99,  100, NONE,  101, NONE,  102, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE,
+    },
+    /* U+00C0 - U+00DF */ {
+        NONE, NONE, NONE, NONE,  103, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE,
+        NONE, NONE, NONE, NONE, NONE, NONE,  104, NONE, NONE, NONE, NONE, NONE,  105, NONE, NONE,  106,
+    },
+    /* U+00E0 - U+00FF */ {
+         107,  108,  109, NONE,  110, NONE, NONE,  111,  112,  113,  114,  115,  116,  117,  118,  119,
+        NONE,  120,  121,  122,  123, NONE,  124, NONE, NONE,  125,  126,  127,  128, NONE, NONE, NONE,
+    },
+};
+
+/* Map row + 1 for each block of 32 characters from U+0020, 0 for none */
+static const uint8_t font8x8_basic_blocks[] = {
+    1, 2, 3, 0, 4, 5, 6,
+};
+
+#undef NONE
+
 const font_t font8x8_basic = {
     .base         = &font8x8_basic_tr_table[0][0],
-    .flags        = font_flag_fixed,
+    .flags        = font_flag_fixed | font_flag_sparse,
     .first_ch     = 0x20,
-    .last_ch      = 0x7F,
+    .last_ch      = 0xFF,
     .space_ch     = 0x20,
     .width        = 8,
     .height       = 8,
+    .map_blocks   = font8x8_basic_blocks,
+    .map          = font8x8_basic_map,
+    .replacement_ch = 0x7F,
 };
 
 #endif /* MAIN_FONT8X8_BASIC_H_ */
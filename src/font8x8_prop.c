@@ -0,0 +1,220 @@
+/*
+ * font8x8_prop.c
+ *
+ * Variable pitch version of font8x8_basic: each glyph keeps only its inked
+ * columns plus one blank column of spacing, and the space is three columns.
+ * Covers U+0020 - U+007E, with U+007F drawn as the replacement box.
+ */
+#include <sys/types.h>
+#include "font.h"
+
+/* Glyph columns back to back, one byte per column */
+static uint8_t font8x8_prop_data[] = {
+    0x00, 0x00, 0x00, // U+0020 (space)
+    0x06, 0x5F, 0x5F, 0x06, 0x00, // U+0021 (!)
+    0x03, 0x03, 0x00, 0x03, 0x03, 0x00, // U+0022 (")
+    0x14, 0x7F, 0x7F, 0x14, 0x7F, 0x7F, 0x14, 0x00, // U+0023 (#)
+    0x24, 0x2E, 0x6B, 0x6B, 0x3A, 0x12, 0x00, // U+0024 ($)
+    0x46, 0x66, 0x30, 0x18, 0x0C, 0x66, 0x62, 0x00, // U+0025 (%)
+    0x30, 0x7A, 0x4F, 0x5D, 0x37, 0x7A, 0x48, 0x00, // U+0026 (&)
+    0x04, 0x07, 0x03, 0x00, // U+0027 (')
+    0x1C, 0x3E, 0x63, 0x41, 0x00, // U+0028 (()
+    0x41, 0x63, 0x3E, 0x1C, 0x00, // U+0029 ())
+    0x08, 0x2A, 0x3E, 0x1C, 0x1C, 0x3E, 0x2A, 0x08, 0x00, // U+002A (*)
+    0x08, 0x08, 0x3E, 0x3E, 0x08, 0x08, 0x00, // U+002B (+)
+    0x80, 0xE0, 0x60, 0x00, // U+002C (,)
+    0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, // U+002D (-)
+    0x60, 0x60, 0x00, // U+002E (.)
+    0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00, // U+002F (/)
+    0x3E, 0x7F, 0x71, 0x59, 0x4D, 0x7F, 0x3E, 0x00, // U+0030 (0)
+    0x40, 0x42, 0x7F, 0x7F, 0x40, 0x40, 0x00, // U+0031 (1)
+    0x62, 0x73, 0x59, 0x49, 0x6F, 0x66, 0x00, // U+0032 (2)
+    0x22, 0x63, 0x49, 0x49, 0x7F, 0x36, 0x00, // U+0033 (3)
+    0x18, 0x1C, 0x16, 0x53, 0x7F, 0x7F, 0x50, 0x00, // U+0034 (4)
+    0x27, 0x67, 0x45, 0x45, 0x7D, 0x39, 0x00, // U+0035 (5)
+    0x3C, 0x7E, 0x4B, 0x49, 0x79, 0x30, 0x00, // U+0036 (6)
+    0x03, 0x03, 0x71, 0x79, 0x0F, 0x07, 0x00, // U+0037 (7)
+    0x36, 0x7F, 0x49, 0x49, 0x7F, 0x36, 0x00, // U+0038 (8)
+    0x06, 0x4F, 0x49, 0x69, 0x3F, 0x1E, 0x00, // U+0039 (9)
+    0x66, 0x66, 0x00, // U+003A (:)
+    0x80, 0xE6, 0x66, 0x00, // U+003B (;)
+    0x08, 0x1C, 0x36, 0x63, 0x41, 0x00, // U+003C (<)
+    0x24, 0x24, 0x24, 0x24, 0x24, 0x24, 0x00, // U+003D (=)
+    0x41, 0x63, 0x36, 0x1C, 0x08, 0x00, // U+003E (>)
+    0x02, 0x03, 0x51, 0x59, 0x0F, 0x06, 0x00, // U+003F (?)
+    0x3E, 0x7F, 0x41, 0x5D, 0x5D, 0x1F, 0x1E, 0x00, // U+0040 (@)
+    0x7C, 0x7E, 0x13, 0x13, 0x7E, 0x7C, 0x00, // U+0041 (A)
+    0x41, 0x7F, 0x7F, 0x49, 0x49, 0x7F, 0x36, 0x00, // U+0042 (B)
+    0x1C, 0x3E, 0x63, 0x41, 0x41, 0x63, 0x22, 0x00, // U+0043 (C)
+    0x41, 0x7F, 0x7F, 0x41, 0x63, 0x3E, 0x1C, 0x00, // U+0044 (D)
+    0x41, 0x7F, 0x7F, 0x49, 0x5D, 0x41, 0x63, 0x00, // U+0045 (E)
+    0x41, 0x7F, 0x7F, 0x49, 0x1D, 0x01, 0x03, 0x00, // U+0046 (F)
+    0x1C, 0x3E, 0x63, 0x41, 0x51, 0x73, 0x72, 0x00, // U+0047 (G)
+    0x7F, 0x7F, 0x08, 0x08, 0x7F, 0x7F, 0x00, // U+0048 (H)
+    0x41, 0x7F, 0x7F, 0x41, 0x00, // U+0049 (I)
+    0x30, 0x70, 0x40, 0x41, 0x7F, 0x3F, 0x01, 0x00, // U+004A (J)
+    0x41, 0x7F, 0x7F, 0x08, 0x1C, 0x77, 0x63, 0x00, // U+004B (K)
+    0x41, 0x7F, 0x7F, 0x41, 0x40, 0x60, 0x70, 0x00, // U+004C (L)
+    0x7F, 0x7F, 0x0E, 0x1C, 0x0E, 0x7F, 0x7F, 0x00, // U+004D (M)
+    0x7F, 0x7F, 0x06, 0x0C, 0x18, 0x7F, 0x7F, 0x00, // U+004E (N)
+    0x1C, 0x3E, 0x63, 0x41, 0x63, 0x3E, 0x1C, 0x00, // U+004F (O)
+    0x41, 0x7F, 0x7F, 0x49, 0x09, 0x0F, 0x06, 0x00, // U+0050 (P)
+    0x1E, 0x3F, 0x21, 0x71, 0x7F, 0x5E, 0x00, // U+0051 (Q)
+    0x41, 0x7F, 0x7F, 0x09, 0x19, 0x7F, 0x66, 0x00, // U+0052 (R)
+    0x26, 0x6F, 0x4D, 0x59, 0x73, 0x32, 0x00, // U+0053 (S)
+    0x03, 0x41, 0x7F, 0x7F, 0x41, 0x03, 0x00, // U+0054 (T)
+    0x7F, 0x7F, 0x40, 0x40, 0x7F, 0x7F, 0x00, // U+0055 (U)
+    0x1F, 0x3F, 0x60, 0x60, 0x3F, 0x1F, 0x00, // U+0056 (V)
+    0x7F, 0x7F, 0x30, 0x18, 0x30, 0x7F, 0x7F, 0x00, // U+0057 (W)
+    0x43, 0x67, 0x3C, 0x18, 0x3C, 0x67, 0x43, 0x00, // U+0058 (X)
+    0x07, 0x4F, 0x78, 0x78, 0x4F, 0x07, 0x00, // U+0059 (Y)
+    0x47, 0x63, 0x71, 0x59, 0x4D, 0x67, 0x73, 0x00, // U+005A (Z)
+    0x7F, 0x7F, 0x41, 0x41, 0x00, // U+005B ([)
+    0x01, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x00, // U+005C (\)
+    0x41, 0x41, 0x7F, 0x7F, 0x00, // U+005D (])
+    0x08, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x08, 0x00, // U+005E (^)
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, // U+005F (_)
+    0x03, 0x07, 0x04, 0x00, // U+0060 (`)
+    0x20, 0x74, 0x54, 0x54, 0x3C, 0x78, 0x40, 0x00, // U+0061 (a)
+    0x41, 0x7F, 0x3F, 0x48, 0x48, 0x78, 0x30, 0x00, // U+0062 (b)
+    0x38, 0x7C, 0x44, 0x44, 0x6C, 0x28, 0x00, // U+0063 (c)
+    0x30, 0x78, 0x48, 0x49, 0x3F, 0x7F, 0x40, 0x00, // U+0064 (d)
+    0x38, 0x7C, 0x54, 0x54, 0x5C, 0x18, 0x00, // U+0065 (e)
+    0x48, 0x7E, 0x7F, 0x49, 0x03, 0x02, 0x00, // U+0066 (f)
+    0x98, 0xBC, 0xA4, 0xA4, 0xF8, 0x7C, 0x04, 0x00, // U+0067 (g)
+    0x41, 0x7F, 0x7F, 0x08, 0x04, 0x7C, 0x78, 0x00, // U+0068 (h)
+    0x44, 0x7D, 0x7D, 0x40, 0x00, // U+0069 (i)
+    0x60, 0xE0, 0x80, 0x80, 0xFD, 0x7D, 0x00, // U+006A (j)
+    0x41, 0x7F, 0x7F, 0x10, 0x38, 0x6C, 0x44, 0x00, // U+006B (k)
+    0x41, 0x7F, 0x7F, 0x40, 0x00, // U+006C (l)
+    0x7C, 0x7C, 0x18, 0x38, 0x1C, 0x7C, 0x78, 0x00, // U+006D (m)
+    0x7C, 0x7C, 0x04, 0x04, 0x7C, 0x78, 0x00, // U+006E (n)
+    0x38, 0x7C, 0x44, 0x44, 0x7C, 0x38, 0x00, // U+006F (o)
+    0x84, 0xFC, 0xF8, 0xA4, 0x24, 0x3C, 0x18, 0x00, // U+0070 (p)
+    0x18, 0x3C, 0x24, 0xA4, 0xF8, 0xFC, 0x84, 0x00, // U+0071 (q)
+    0x44, 0x7C, 0x78, 0x4C, 0x04, 0x1C, 0x18, 0x00, // U+0072 (r)
+    0x48, 0x5C, 0x54, 0x54, 0x74, 0x24, 0x00, // U+0073 (s)
+    0x04, 0x3E, 0x7F, 0x44, 0x24, 0x00, // U+0074 (t)
+    0x3C, 0x7C, 0x40, 0x40, 0x3C, 0x7C, 0x40, 0x00, // U+0075 (u)
+    0x1C, 0x3C, 0x60, 0x60, 0x3C, 0x1C, 0x00, // U+0076 (v)
+    0x3C, 0x7C, 0x70, 0x38, 0x70, 0x7C, 0x3C, 0x00, // U+0077 (w)
+    0x44, 0x6C, 0x38, 0x10, 0x38, 0x6C, 0x44, 0x00, // U+0078 (x)
+    0x9C, 0xBC, 0xA0, 0xA0, 0xFC, 0x7C, 0x00, // U+0079 (y)
+    0x4C, 0x64, 0x74, 0x5C, 0x4C, 0x64, 0x00, // U+007A (z)
+    0x08, 0x08, 0x3E, 0x77, 0x41, 0x41, 0x00, // U+007B ({)
+    0x77, 0x77, 0x00, // U+007C (|)
+    0x41, 0x41, 0x77, 0x3E, 0x08, 0x08, 0x00, // U+007D (})
+    0x02, 0x03, 0x01, 0x03, 0x02, 0x03, 0x01, 0x00, // U+007E (~)
+    0x7F, 0x41, 0x41, 0x41, 0x41, 0x7F, 0x00, // U+007F (replacement)
+};
+
+static const font_glyph_t font8x8_prop_glyphs[] = {
+    {    0, 3 },  // U+0020 (space)
+    {    3, 5 },  // U+0021 (!)
+    {    8, 6 },  // U+0022 (")
+    {   14, 8 },  // U+0023 (#)
+    {   22, 7 },  // U+0024 ($)
+    {   29, 8 },  // U+0025 (%)
+    {   37, 8 },  // U+0026 (&)
+    {   45, 4 },  // U+0027 (')
+    {   49, 5 },  // U+0028 (()
+    {   54, 5 },  // U+0029 ())
+    {   59, 9 },  // U+002A (*)
+    {   68, 7 },  // U+002B (+)
+    {   75, 4 },  // U+002C (,)
+    {   79, 7 },  // U+002D (-)
+    {   86, 3 },  // U+002E (.)
+    {   89, 8 },  // U+002F (/)
+    {   97, 8 },  // U+0030 (0)
+    {  105, 7 },  // U+0031 (1)
+    {  112, 7 },  // U+0032 (2)
+    {  119, 7 },  // U+0033 (3)
+    {  126, 8 },  // U+0034 (4)
+    {  134, 7 },  // U+0035 (5)
+    {  141, 7 },  // U+0036 (6)
+    {  148, 7 },  // U+0037 (7)
+    {  155, 7 },  // U+0038 (8)
+    {  162, 7 },  // U+0039 (9)
+    {  169, 3 },  // U+003A (:)
+    {  172, 4 },  // U+003B (;)
+    {  176, 6 },  // U+003C (<)
+    {  182, 7 },  // U+003D (=)
+    {  189, 6 },  // U+003E (>)
+    {  195, 7 },  // U+003F (?)
+    {  202, 8 },  // U+0040 (@)
+    {  210, 7 },  // U+0041 (A)
+    {  217, 8 },  // U+0042 (B)
+    {  225, 8 },  // U+0043 (C)
+    {  233, 8 },  // U+0044 (D)
+    {  241, 8 },  // U+0045 (E)
+    {  249, 8 },  // U+0046 (F)
+    {  257, 8 },  // U+0047 (G)
+    {  265, 7 },  // U+0048 (H)
+    {  272, 5 },  // U+0049 (I)
+    {  277, 8 },  // U+004A (J)
+    {  285, 8 },  // U+004B (K)
+    {  293, 8 },  // U+004C (L)
+    {  301, 8 },  // U+004D (M)
+    {  309, 8 },  // U+004E (N)
+    {  317, 8 },  // U+004F (O)
+    {  325, 8 },  // U+0050 (P)
+    {  333, 7 },  // U+0051 (Q)
+    {  340, 8 },  // U+0052 (R)
+    {  348, 7 },  // U+0053 (S)
+    {  355, 7 },  // U+0054 (T)
+    {  362, 7 },  // U+0055 (U)
+    {  369, 7 },  // U+0056 (V)
+    {  376, 8 },  // U+0057 (W)
+    {  384, 8 },  // U+0058 (X)
+    {  392, 7 },  // U+0059 (Y)
+    {  399, 8 },  // U+005A (Z)
+    {  407, 5 },  // U+005B ([)
+    {  412, 8 },  // U+005C (\)
+    {  420, 5 },  // U+005D (])
+    {  425, 8 },  // U+005E (^)
+    {  433, 9 },  // U+005F (_)
+    {  442, 4 },  // U+0060 (`)
+    {  446, 8 },  // U+0061 (a)
+    {  454, 8 },  // U+0062 (b)
+    {  462, 7 },  // U+0063 (c)
+    {  469, 8 },  // U+0064 (d)
+    {  477, 7 },  // U+0065 (e)
+    {  484, 7 },  // U+0066 (f)
+    {  491, 8 },  // U+0067 (g)
+    {  499, 8 },  // U+0068 (h)
+    {  507, 5 },  // U+0069 (i)
+    {  512, 7 },  // U+006A (j)
+    {  519, 8 },  // U+006B (k)
+    {  527, 5 },  // U+006C (l)
+    {  532, 8 },  // U+006D (m)
+    {  540, 7 },  // U+006E (n)
+    {  547, 7 },  // U+006F (o)
+    {  554, 8 },  // U+0070 (p)
+    {  562, 8 },  // U+0071 (q)
+    {  570, 8 },  // U+0072 (r)
+    {  578, 7 },  // U+0073 (s)
+    {  585, 6 },  // U+0074 (t)
+    {  591, 8 },  // U+0075 (u)
+    {  599, 7 },  // U+0076 (v)
+    {  606, 8 },  // U+0077 (w)
+    {  614, 8 },  // U+0078 (x)
+    {  622, 7 },  // U+0079 (y)
+    {  629, 7 },  // U+007A (z)
+    {  636, 7 },  // U+007B ({)
+    {  643, 3 },  // U+007C (|)
+    {  646, 7 },  // U+007D (})
+    {  653, 8 },  // U+007E (~)
+    {  661, 7 }   // U+007F (replacement)
+};
+
+const font_t font8x8_prop = {
+    .base         = font8x8_prop_data,
+    .flags        = font_flag_variable,
+    .first_ch     = 0x20,
+    .last_ch      = 0x7F,
+    .space_ch     = 0x20,
+    .width        = 9,
+    .height       = 8,
+    .glyphs       = font8x8_prop_glyphs,
+    .replacement_ch = 0x7F,
+};
@@ -7,6 +7,7 @@
 
 #if CONFIG_SSD1306_I2C_ENABLED
 
+#include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
 
@@ -20,6 +21,8 @@
 
 
 #include "display.h"
+#include "display_trace.h"
+#include "ssd1306_i2c.h"
 #include "ssd1306_i2c_internal.h"
 #include "font.h"
 
@@ -46,6 +49,54 @@ ESP_LOGI(TAG, "%s: reset_pin %d", __func__, driver_info->reset_pin);
 }
 
 
+/*
+ * Command links are built in storage preallocated by create when
+ * CONFIG_SSD1306_I2C_STATIC_LINKS is set, so no transfer touches the heap.
+ */
+static i2c_cmd_handle_t ssd1306_i2c_link_create(uint8_t *buffer, size_t size)
+{
+#if CONFIG_SSD1306_I2C_STATIC_LINKS
+    return i2c_cmd_link_create_static(buffer, size);
+#else
+    return i2c_cmd_link_create();
+#endif
+}
+
+static void ssd1306_i2c_link_delete(i2c_cmd_handle_t cmd)
+{
+#if CONFIG_SSD1306_I2C_STATIC_LINKS
+    i2c_cmd_link_delete_static(cmd);
+#else
+    i2c_cmd_link_delete(cmd);
+#endif
+}
+
+/*
+ * Send a command stream.  Called with the display locked.
+ */
+static esp_err_t ssd1306_i2c_send_commands(display_t* display, const uint8_t *commands, int count, TickType_t ticks)
+{
+    ssd1306_i2c_driver_info* driver_info = (ssd1306_i2c_driver_info*) (display->driver_info);
+
+#if CONFIG_SSD1306_I2C_STATIC_LINKS
+    i2c_cmd_handle_t cmd = ssd1306_i2c_link_create(driver_info->command_link, sizeof(driver_info->command_link));
+#else
+    i2c_cmd_handle_t cmd = ssd1306_i2c_link_create(NULL, 0);
+#endif
+
+    ESP_ERROR_CHECK(i2c_master_start(cmd));
+    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (CONFIG_SSD1306_I2C_ADDR << 1) | I2C_MASTER_WRITE, true));
+    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CONTROL_BYTE_CMD_STREAM, true));
+    ESP_ERROR_CHECK(i2c_master_write(cmd, commands, count, true));
+    ESP_ERROR_CHECK(i2c_master_stop(cmd));
+
+    esp_err_t err = i2c_master_cmd_begin(driver_info->i2c_num, cmd, ticks);
+
+    ssd1306_i2c_link_delete(cmd);
+
+    return err;
+}
+
 static void i2c_master_init(display_t* display, int i2c_num, int sda_pin, int scl_pin, int reset_pin, int clk_speed)
 {
     ssd1306_i2c_driver_info* driver_info = (ssd1306_i2c_driver_info*) (display->driver_info);
@@ -88,69 +139,52 @@ void ssd1306_i2c_init(display_t* display)
 
     ssd1306_i2c_driver_info* driver_info = (ssd1306_i2c_driver_info*) (display->driver_info);
 
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    const uint8_t commands[] = {
+        SSD1306_CMD_DISPLAY_OFF,
 
-    ESP_ERROR_CHECK(i2c_master_start(cmd));
+        SSD1306_CMD_SET_MUX_RATIO,
+        display->height - 1,
 
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (CONFIG_SSD1306_I2C_ADDR << 1) | I2C_MASTER_WRITE, true));
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CONTROL_BYTE_CMD_STREAM, true));
-
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CMD_DISPLAY_OFF, true));
-
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CMD_SET_MUX_RATIO, true));
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, display->height - 1, true));
-
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CMD_SET_DISPLAY_OFFSET, true));
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, 0x00, true));
+        SSD1306_CMD_SET_DISPLAY_OFFSET,
+        0x00,
 
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CMD_SET_DISPLAY_START_LINE | 0x00, true));
+        SSD1306_CMD_SET_DISPLAY_START_LINE | 0x00,
 
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, display->flags & DISPLAY_FLAGS_MIRROR_X ? SSD1306_CMD_SET_SEGMENT_NORMAL : SSD1306_CMD_SET_SEGMENT_REMAP, true));
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, display->flags & DISPLAY_FLAGS_MIRROR_Y ? SSD1306_CMD_SET_COM_SCAN_NORMAL : SSD1306_CMD_SET_COM_SCAN_REMAP, true));
+        display->flags & DISPLAY_FLAGS_MIRROR_X ? SSD1306_CMD_SET_SEGMENT_NORMAL : SSD1306_CMD_SET_SEGMENT_REMAP,
+        display->flags & DISPLAY_FLAGS_MIRROR_Y ? SSD1306_CMD_SET_COM_SCAN_NORMAL : SSD1306_CMD_SET_COM_SCAN_REMAP,
 
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CMD_SET_COM_PIN_MAP, true));
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, display->height == 32 ? 0x10 : 0x12, true)); // 0x10 if 32 lines else 0x12
+        SSD1306_CMD_SET_COM_PIN_MAP,
+        display->height == 32 ? 0x10 : 0x12, // 0x10 if 32 lines else 0x12
 
-    /* Initial brightness as 0 so old stuff doesn't get displayed */
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CMD_SET_CONTRAST, true));
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, 0, true));
+        /* Initial brightness as 0 so old stuff doesn't get displayed */
+        SSD1306_CMD_SET_CONTRAST,
+        0,
 
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CMD_DISPLAY_RAM, true));
+        SSD1306_CMD_DISPLAY_RAM,
 
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CMD_DISPLAY_NORMAL, true));
+        SSD1306_CMD_DISPLAY_NORMAL,
 
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CMD_SET_DISPLAY_CLK_DIV, true));
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, 0x80, true));  // 0x80?
+        SSD1306_CMD_SET_DISPLAY_CLK_DIV,
+        0x80,  // 0x80?
 
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CMD_SET_CHARGE_PUMP, true));
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_EXTERNAL_VCC ? 0x14 : 0x10, true));
+        SSD1306_CMD_SET_CHARGE_PUMP,
+        SSD1306_EXTERNAL_VCC ? 0x14 : 0x10,
 
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CMD_DISPLAY_ON, true));
+        SSD1306_CMD_DISPLAY_ON,
 
+        SSD1306_CMD_SET_MEMORY_ADDR_MODE,
+        SSD1306_PARAM_MEMORY_ADDR_MODE_HORIZONTAL,
 
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CMD_SET_MEMORY_ADDR_MODE, true));
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_PARAM_MEMORY_ADDR_MODE_HORIZONTAL, true));
+        SSD1306_CMD_SET_PRECHARGE,
+        0x22,
 
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CMD_SET_PRECHARGE, true));
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, 0x22, true));
-
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CMD_SET_VCOMH_DESELECT, true));
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, 0x30, true));
-
-    ESP_ERROR_CHECK(i2c_master_stop(cmd));
-
-ESP_LOGI(TAG, "%s: i2c_num %d cmd %p port tick period %d", __func__, driver_info->i2c_num, cmd, portTICK_PERIOD_MS);
+        SSD1306_CMD_SET_VCOMH_DESELECT,
+        0x30,
+    };
 
-    ESP_ERROR_CHECK(i2c_master_cmd_begin(driver_info->i2c_num, cmd, 1000/portTICK_PERIOD_MS));
-//    esp_error_t espRc = i2c_master_cmd_begin(driver_info->i2c_num, cmd, 10/portTICK_PERIOD_MS);
-//
-//    if (espRc == ESP_OK) {
-//        ESP_LOGI(TAG, "%s: OLED configured successfully", __func__);
-//    } else {
-//        ESP_LOGE(TAG, "%s: OLED configuration failed. code: 0x%.2X", __func__, espRc);
-//    }
+ESP_LOGI(TAG, "%s: i2c_num %d port tick period %d", __func__, driver_info->i2c_num, portTICK_PERIOD_MS);
 
-    i2c_cmd_link_delete(cmd);
+    ESP_ERROR_CHECK(ssd1306_i2c_send_commands(display, commands, sizeof(commands), 1000/portTICK_PERIOD_MS));
 
     display->_unlock(display);
 }
@@ -166,75 +200,456 @@ static void ssd1306_i2c_deinit(display_t* display)
 
 static void ssd1306_i2c_enable(display_t* display, bool enable)
 {
+    DISPLAY_TRACE(display_trace_op_enable, enable, 0, 0, 0);
+
     display->_lock(display);
 
-    ssd1306_i2c_driver_info* driver_info = (ssd1306_i2c_driver_info*) (display->driver_info);
+    const uint8_t commands[] = {
+        enable ? SSD1306_CMD_DISPLAY_ON : SSD1306_CMD_DISPLAY_OFF,
+    };
 
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    ssd1306_i2c_send_commands(display, commands, sizeof(commands), 10/portTICK_PERIOD_MS);
 
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (CONFIG_SSD1306_I2C_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, SSD1306_CONTROL_BYTE_CMD_SINGLE, true);
-    i2c_master_write_byte(cmd, enable ? SSD1306_CMD_DISPLAY_ON : SSD1306_CMD_DISPLAY_OFF, true);
-    i2c_master_stop(cmd);
+    display->_unlock(display);
+}
 
-    i2c_master_cmd_begin(driver_info->i2c_num, cmd, 10/portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(cmd);
+static void ssd1306_i2c_contrast(display_t* display, int contrast)
+{
+    DISPLAY_TRACE(display_trace_op_contrast, contrast, 0, 0, 0);
+
+    display->_lock(display);
+
+    const uint8_t commands[] = {
+        SSD1306_CMD_SET_CONTRAST,
+        contrast,
+    };
+
+    ssd1306_i2c_send_commands(display, commands, sizeof(commands), 10/portTICK_PERIOD_MS);
 
     display->_unlock(display);
 }
 
-static void ssd1306_i2c_contrast(display_t* display, int contrast)
+#if CONFIG_DISPLAY_SCROLL_ENABLED
+/* Scroll step intervals the controller supports, indexed by setting */
+static const uint16_t ssd1306_scroll_intervals[8] = { 5, 64, 128, 256, 3, 4, 25, 2 };
+
+/*
+ * Let the controller scroll part of the panel on its own; no bus traffic or
+ * drawing is needed until stop_scroll.  Frames is rounded to the nearest
+ * supported interval.  GDDRAM must not be written while the scroll runs, so
+ * pending transfers finish first and show() sends nothing until stop_scroll.
+ */
+static void ssd1306_i2c_start_scroll(display_t* display, display_scroll_t direction, int page1, int page2, int frames, int offset)
 {
+    DISPLAY_TRACE(display_trace_op_scroll, direction, page1, page2, frames);
+
+    static const uint8_t scroll_commands[] = {
+        [display_scroll_right]    = SSD1306_CMD_SCROLL_RIGHT,
+        [display_scroll_left]     = SSD1306_CMD_SCROLL_LEFT,
+        [display_scroll_up_right] = SSD1306_CMD_SCROLL_UP_RIGHT,
+        [display_scroll_up_left]  = SSD1306_CMD_SCROLL_UP_LEFT,
+    };
+
+    if ((unsigned) direction >= sizeof(scroll_commands) / sizeof(scroll_commands[0])) {
+        ESP_LOGE(TAG, "%s: bad direction %d", __func__, (int) direction);
+        return;
+    }
+
+    int interval = 0;
+
+    for (size_t index = 1; index < sizeof(ssd1306_scroll_intervals) / sizeof(ssd1306_scroll_intervals[0]); ++index) {
+        if (abs(ssd1306_scroll_intervals[index] - frames) < abs(ssd1306_scroll_intervals[interval] - frames)) {
+            interval = index;
+        }
+    }
+
+    if (page1 < 0) {
+        page1 = 0;
+    }
+    if (page2 > display->pages - 1) {
+        page2 = display->pages - 1;
+    }
+    if (page1 > page2) {
+        ESP_LOGE(TAG, "%s: bad page range %d..%d", __func__, page1, page2);
+        return;
+    }
+
+    bool vertical = direction == display_scroll_up_right || direction == display_scroll_up_left;
+
+    uint8_t commands[12];
+    int count = 0;
+
+    /* Setup must not change while a scroll is running */
+    commands[count++] = SSD1306_CMD_SCROLL_STOP;
+
+    if (vertical) {
+        commands[count++] = SSD1306_CMD_SET_SCROLL_AREA;
+        commands[count++] = 0;
+        commands[count++] = display->height;
+    }
+
+    commands[count++] = scroll_commands[direction];
+    commands[count++] = 0x00;
+    commands[count++] = page1;
+    commands[count++] = interval;
+    commands[count++] = page2;
+
+    if (vertical) {
+        commands[count++] = offset % display->height;
+    } else {
+        commands[count++] = 0x00;
+        commands[count++] = 0xFF;
+    }
+
+    commands[count++] = SSD1306_CMD_SCROLL_START;
+
+    /* Hold back new transfers, then let one already under way finish */
     display->_lock(display);
+    display->scrolling = true;
+    display->_unlock(display);
 
-    ssd1306_i2c_driver_info* driver_info = (ssd1306_i2c_driver_info*) (display->driver_info);
+    display->wait_flushed(display, portMAX_DELAY);
 
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (CONFIG_SSD1306_I2C_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, SSD1306_CONTROL_BYTE_CMD_STREAM, true);
-    i2c_master_write_byte(cmd, SSD1306_CMD_SET_CONTRAST, true);
-    i2c_master_write_byte(cmd, contrast, true);
+    display->_lock(display);
 
-    i2c_master_stop(cmd);
-    i2c_master_cmd_begin(driver_info->i2c_num, cmd, 10/portTICK_PERIOD_MS);
-    i2c_cmd_link_delete(cmd);
+    ssd1306_i2c_send_commands(display, commands, count, 10/portTICK_PERIOD_MS);
 
     display->_unlock(display);
 }
 
 /*
- * Write current frame buffer to device.
+ * Stop scrolling and bring the panel back to the frame buffer: scrolling moves
+ * GDDRAM contents, so the whole frame is sent again.
  */
-static void ssd1306_i2c_show(display_t* display)
+static void ssd1306_i2c_stop_scroll(display_t* display)
 {
+    DISPLAY_TRACE(display_trace_op_scroll, -1, 0, 0, 0);
+
+    /* No transfer may be in flight while the shadow is reset */
+    display->wait_flushed(display, portMAX_DELAY);
+
     display->_lock(display);
 
-    ssd1306_i2c_driver_info* driver_info = (ssd1306_i2c_driver_info*) (display->driver_info);
+    const uint8_t commands[] = {
+        SSD1306_CMD_SCROLL_STOP,
+    };
 
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    ssd1306_i2c_send_commands(display, commands, sizeof(commands), 10/portTICK_PERIOD_MS);
 
-ESP_LOGI(TAG, "%s: cmd %p,  %d bytes", __func__, cmd, display->frame_len);
+    display->scrolling = false;
 
-    ESP_ERROR_CHECK(i2c_master_start(cmd));
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, (CONFIG_SSD1306_I2C_ADDR << 1) | I2C_MASTER_WRITE, true));
-    ESP_ERROR_CHECK(i2c_master_write_byte(cmd, SSD1306_CONTROL_BYTE_DATA_STREAM, true));
-    ESP_ERROR_CHECK(i2c_master_write(cmd, display->frame_buf, display->frame_len, true));
-    ESP_ERROR_CHECK(i2c_master_stop(cmd));
+#if CONFIG_SSD1306_I2C_SHADOW_DIFF
+    ((ssd1306_i2c_driver_info*) (display->driver_info))->shadow_valid = false;
+#endif
 
-    ESP_ERROR_CHECK(i2c_master_cmd_begin(driver_info->i2c_num, cmd, 10/portTICK_PERIOD_MS));
+    display->hold(display);
 
-    i2c_cmd_link_delete(cmd);
+    display->_mark_dirty(display, 0, 0, display->width, display->height);
+
+    display->show(display);
 
     display->_unlock(display);
 }
+#endif /* CONFIG_DISPLAY_SCROLL_ENABLED */
+
+/*
+ * Queue one update window: select the column and page range, then stream the
+ * frame buffer bytes that fall inside it.  Returns the number of bus bytes used.
+ */
+static int ssd1306_i2c_queue_window(display_t* display, i2c_cmd_handle_t cmd, ssd1306_window_t *window)
+{
+    static const uint8_t data_header[] = {
+        (CONFIG_SSD1306_I2C_ADDR << 1) | I2C_MASTER_WRITE,
+        SSD1306_CONTROL_BYTE_DATA_STREAM,
+    };
+
+    int x1 = window->x1;
+    int x2 = window->x2;
+    int page1 = window->page1;
+    int page2 = window->page2;
+
+    /* Written as single blocks to keep the link short */
+    window->header[0] = (CONFIG_SSD1306_I2C_ADDR << 1) | I2C_MASTER_WRITE;
+    window->header[1] = SSD1306_CONTROL_BYTE_CMD_STREAM;
+    window->header[2] = SSD1306_CMD_SET_COLUMN_RANGE;
+    window->header[3] = x1;
+    window->header[4] = x2;
+    window->header[5] = SSD1306_CMD_SET_PAGE_RANGE;
+    window->header[6] = page1;
+    window->header[7] = page2;
+
+    ESP_ERROR_CHECK(i2c_master_start(cmd));
+    ESP_ERROR_CHECK(i2c_master_write(cmd, window->header, sizeof(window->header), true));
+
+    ESP_ERROR_CHECK(i2c_master_start(cmd));
+    ESP_ERROR_CHECK(i2c_master_write(cmd, data_header, sizeof(data_header), true));
+
+    if (x1 == 0 && x2 == display->width - 1) {
+        /* Full rows are contiguous in the frame buffer */
+        ESP_ERROR_CHECK(i2c_master_write(cmd, &display->show_buf[page1 * display->width], (page2 - page1 + 1) * display->width, true));
+    } else {
+        for (int page = page1; page <= page2; ++page) {
+            ESP_ERROR_CHECK(i2c_master_write(cmd, &display->show_buf[page * display->width + x1], x2 - x1 + 1, true));
+        }
+    }
+
+    return SSD1306_WINDOW_OVERHEAD + (x2 - x1 + 1) * (page2 - page1 + 1);
+}
+
+#if !CONFIG_SSD1306_I2C_SHADOW_DIFF
+/*
+ * Plan windows from the dirty ranges: runs of consecutive dirty pages become one
+ * window spanning the union of their column ranges.
+ */
+static int ssd1306_i2c_plan_dirty(display_t* display, ssd1306_window_t *windows)
+{
+    int count = 0;
+    int page = 0;
+
+    while (page < display->pages) {
+        display_dirty_t *dirty = &display->show_dirty[page];
+
+        if (dirty->x1 > dirty->x2) {
+            ++page;
+        } else {
+            ssd1306_window_t *window = &windows[count++];
+
+            window->x1 = dirty->x1;
+            window->x2 = dirty->x2;
+            window->page1 = page;
+
+            /* Extend the window over following dirty pages */
+            while (++page < display->pages && display->show_dirty[page].x1 <= display->show_dirty[page].x2) {
+                dirty = &display->show_dirty[page];
+
+                if (dirty->x1 < window->x1) {
+                    window->x1 = dirty->x1;
+                }
+                if (dirty->x2 > window->x2) {
+                    window->x2 = dirty->x2;
+                }
+            }
+
+            window->page2 = page - 1;
+        }
+    }
+
+    return count;
+}
+#endif
+
+#if CONFIG_SSD1306_I2C_SHADOW_DIFF
+/*
+ * Add the changed run x1..x2 of a page to the plan.  The run is folded into an
+ * existing window ending on this page (widening it) or on the page above
+ * (growing it down) when the extra payload is no more than opening a window.
+ */
+static int ssd1306_i2c_plan_run(ssd1306_window_t *windows, int count, int page, int x1, int x2)
+{
+    int best = -1;
+    int best_cost = SSD1306_WINDOW_COST + (x2 - x1 + 1);
+
+    for (int index = 0; index < count; ++index) {
+        ssd1306_window_t *window = &windows[index];
+
+        if (window->page2 == page || window->page2 == page - 1) {
+            int u1 = x1 < window->x1 ? x1 : window->x1;
+            int u2 = x2 > window->x2 ? x2 : window->x2;
+            int pages = window->page2 - window->page1 + 1;
+            int grown = window->page2 == page ? pages : pages + 1;
+
+            int cost = (u2 - u1 + 1) * grown - (window->x2 - window->x1 + 1) * pages;
+
+            if (cost <= best_cost) {
+                best = index;
+                best_cost = cost;
+            }
+        }
+    }
+
+    if (best >= 0) {
+        ssd1306_window_t *window = &windows[best];
+
+        if (x1 < window->x1) {
+            window->x1 = x1;
+        }
+        if (x2 > window->x2) {
+            window->x2 = x2;
+        }
+        window->page2 = page;
+    } else {
+        ssd1306_window_t *window = &windows[count++];
+
+        window->x1 = x1;
+        window->x2 = x2;
+        window->page1 = page;
+        window->page2 = page;
+    }
+
+    return count;
+}
+
+/*
+ * Plan windows by comparing the dirty part of the frame buffer with the shadow
+ * copy of GDDRAM.  Changed bytes separated by a gap cheaper than a new window
+ * are sent as one run.  Falls back to a single full frame window when that
+ * costs less than the planned windows.
+ */
+static int ssd1306_i2c_plan_diff(display_t* display, ssd1306_window_t *windows)
+{
+    ssd1306_i2c_driver_info* driver_info = (ssd1306_i2c_driver_info*) (display->driver_info);
+
+    int count = 0;
+
+    for (int page = 0; page < display->pages; ++page) {
+        display_dirty_t *dirty = &display->show_dirty[page];
+
+        const uint8_t *frame = &display->show_buf[page * display->width];
+        const uint8_t *shadow = &driver_info->shadow[page * display->width];
+
+        int run1 = -1;
+        int run2 = -1;
+
+        for (int x = dirty->x1; x <= dirty->x2; ++x) {
+            if (frame[x] != shadow[x]) {
+                if (run1 < 0) {
+                    run1 = x;
+                } else if (x - run2 - 1 >= SSD1306_WINDOW_COST) {
+                    count = ssd1306_i2c_plan_run(windows, count, page, run1, run2);
+                    run1 = x;
+                }
+                run2 = x;
+            }
+        }
+
+        if (run1 >= 0) {
+            count = ssd1306_i2c_plan_run(windows, count, page, run1, run2);
+        }
+    }
+
+    int cost = 0;
+
+    for (int index = 0; index < count; ++index) {
+        cost += SSD1306_WINDOW_COST + (windows[index].x2 - windows[index].x1 + 1) * (windows[index].page2 - windows[index].page1 + 1);
+    }
+
+    if (cost >= SSD1306_WINDOW_COST + (int) display->frame_len) {
+        windows[0].x1 = 0;
+        windows[0].x2 = display->width - 1;
+        windows[0].page1 = 0;
+        windows[0].page2 = display->pages - 1;
+        count = 1;
+    }
+
+    return count;
+}
+#endif /* CONFIG_SSD1306_I2C_SHADOW_DIFF */
+
+/*
+ * Write the modified part of the show buffer to device.  Called with the display
+ * locked, or from the flush task which owns show_buf and show_dirty.
+ */
+static void ssd1306_i2c_show(display_t* display)
+{
+    ssd1306_i2c_driver_info* driver_info = (ssd1306_i2c_driver_info*) (display->driver_info);
+
+    ssd1306_window_t *windows = driver_info->windows;
+    int count;
+
+#if CONFIG_SSD1306_I2C_SHADOW_DIFF
+    if (driver_info->shadow_valid) {
+        count = ssd1306_i2c_plan_diff(display, windows);
+    } else {
+        /* Panel contents unknown: send everything once */
+        windows[0].x1 = 0;
+        windows[0].x2 = display->width - 1;
+        windows[0].page1 = 0;
+        windows[0].page2 = display->pages - 1;
+        count = 1;
+    }
+#else
+    count = ssd1306_i2c_plan_dirty(display, windows);
+#endif
+
+    for (int page = 0; page < display->pages; ++page) {
+        display->show_dirty[page].x1 = display->width;
+        display->show_dirty[page].x2 = -1;
+    }
+
+    bool move = display->show_start_line != driver_info->start_line;
+
+    if (count != 0 || move) {
+#if CONFIG_SSD1306_I2C_STATIC_LINKS
+        i2c_cmd_handle_t cmd = ssd1306_i2c_link_create(driver_info->show_link, driver_info->show_link_size);
+#else
+        i2c_cmd_handle_t cmd = ssd1306_i2c_link_create(NULL, 0);
+#endif
+
+        int sent = 0;
+
+        for (int index = 0; index < count; ++index) {
+            sent += ssd1306_i2c_queue_window(display, cmd, &windows[index]);
+        }
+
+        if (move) {
+            /* After the data, so a console line is in place before it scrolls into view */
+            driver_info->start_line = display->show_start_line;
+
+            driver_info->start_line_command[0] = (CONFIG_SSD1306_I2C_ADDR << 1) | I2C_MASTER_WRITE;
+            driver_info->start_line_command[1] = SSD1306_CONTROL_BYTE_CMD_STREAM;
+            driver_info->start_line_command[2] = SSD1306_CMD_SET_DISPLAY_START_LINE | (driver_info->start_line & 0x3F);
+
+            ESP_ERROR_CHECK(i2c_master_start(cmd));
+            ESP_ERROR_CHECK(i2c_master_write(cmd, driver_info->start_line_command, sizeof(driver_info->start_line_command), true));
+
+            sent += sizeof(driver_info->start_line_command);
+        }
+
+DISPLAY_LOGI(TAG, "%s: cmd %p, %d windows, %d bytes", __func__, cmd, count, sent);
+        DISPLAY_TRACE(display_trace_op_flush, count, sent, 0, 0);
+
+        ESP_ERROR_CHECK(i2c_master_stop(cmd));
+
+        ESP_ERROR_CHECK(i2c_master_cmd_begin(driver_info->i2c_num, cmd, 10/portTICK_PERIOD_MS));
+
+        ssd1306_i2c_link_delete(cmd);
+
+#if CONFIG_SSD1306_I2C_SHADOW_DIFF
+        /* The panel now holds the windows just sent */
+        for (int index = 0; index < count; ++index) {
+            for (int page = windows[index].page1; page <= windows[index].page2; ++page) {
+                int offset = page * display->width + windows[index].x1;
+                memcpy(&driver_info->shadow[offset], &display->show_buf[offset], windows[index].x2 - windows[index].x1 + 1);
+            }
+        }
+
+        driver_info->shadow_valid = true;
+#endif
+
+        /* Compare against streaming the whole frame with no addressing */
+        int full = display->frame_len + 2;
+
+        display->stats.frames++;
+        display->stats.bytes_sent += sent;
+
+        if (full > sent) {
+            display->stats.bytes_saved += full - sent;
+        }
+    }
+}
 
 /*
  * Close the device and free structures
  */
 static void ssd1306_i2c_close(display_t* display)
 {
+    /* Let any queued command and frame reach the panel before tearing down */
+#if CONFIG_DISPLAY_RENDER_QUEUE
+    display->wait_rendered(display, portMAX_DELAY);
+#else
+    display->wait_flushed(display, portMAX_DELAY);
+#endif
+
     display->_lock(display);
 
     ssd1306_i2c_driver_info* driver_info = (ssd1306_i2c_driver_info*) (display->driver_info);
@@ -243,14 +658,68 @@ static void ssd1306_i2c_close(display_t* display)
 
     display->_unlock(display);
 
-    free((void*) display->driver_info);
+    i2c_driver_delete(driver_info->i2c_num);
 
-    /* Call the close routine in the parent class (frees the class) */
-    driver_info->close(display);
+    /* The close routine in the parent class (frees the class) */
+    void (*close)(display_t*) = driver_info->close;
 
-    /* Free our local storage */
-    free((void*) driver_info);
+    if (!display->is_static) {
+        free((void*) driver_info->windows);
+#if CONFIG_SSD1306_I2C_STATIC_LINKS
+        free((void*) driver_info->show_link);
+#endif
+#if CONFIG_SSD1306_I2C_SHADOW_DIFF
+        free((void*) driver_info->shadow);
+#endif
 
+        /* Free our local storage */
+        free((void*) driver_info);
+    }
+
+    close(display);
+}
+
+/*
+ * Bring up the bus and panel once the display and driver info buffers exist.
+ */
+static void ssd1306_i2c_setup(display_t *display, int i2c_num, int sda_pin, int scl_pin, int reset_pin, int clk_speed)
+{
+    ssd1306_i2c_driver_info *driver_info = (ssd1306_i2c_driver_info*) (display->driver_info);
+
+#if CONFIG_SSD1306_I2C_SHADOW_DIFF
+    driver_info->shadow_valid = false;
+#endif
+
+    /* Init sets start line 0 */
+    driver_info->start_line = 0;
+
+    /* Assign a default font */
+    display->set_font(display, &font8x8_basic);
+
+    ESP_LOGI(TAG, "%s: initializing i2c num %d sda %d scl %d reset %d speed %d", __func__, i2c_num, sda_pin, scl_pin, reset_pin, clk_speed);
+    i2c_master_init(display, i2c_num, sda_pin, scl_pin, reset_pin, clk_speed);
+
+    ESP_LOGI(TAG, "%s: initializing display", __func__);
+    ssd1306_i2c_init(display);
+
+    /* Plug override for close */
+    driver_info->close     = display->close;
+
+    display->_show         = ssd1306_i2c_show;
+
+    display->close         = ssd1306_i2c_close;
+
+    display->contrast      = ssd1306_i2c_contrast;
+    display->enable        = ssd1306_i2c_enable;
+#if CONFIG_DISPLAY_SCROLL_ENABLED
+    display->start_scroll  = ssd1306_i2c_start_scroll;
+    display->stop_scroll   = ssd1306_i2c_stop_scroll;
+#endif
+
+    /* Clear the display */
+    display->clear(display);
+
+    display->contrast(display, 0x80);
 }
 
 /*
@@ -268,30 +737,61 @@ ESP_LOGI(TAG, "%s: i2c_num %d sda_pin %d scl_pin %d reset_pin %d clk_speed %d wi
 
         display->driver_info = (void*) driver_info;
 
-        /* Assign a default font */
-        display->set_font(display, &font8x8_basic);
+        driver_info->max_windows = SSD1306_MAX_WINDOWS(width, height);
+        driver_info->windows = (ssd1306_window_t*) malloc(driver_info->max_windows * sizeof(ssd1306_window_t));
 
-        ESP_LOGI(TAG, "%s: initializing i2c num %d sda %d scl %d reset %d speed %d", __func__, i2c_num, sda_pin, scl_pin, reset_pin, clk_speed);
-        i2c_master_init(display, i2c_num, sda_pin, scl_pin, reset_pin, clk_speed);
+#if CONFIG_SSD1306_I2C_STATIC_LINKS
+        driver_info->show_link_size = SSD1306_LINK_SIZE(SSD1306_SHOW_LINK_OPS(width, height));
+        driver_info->show_link = (uint8_t*) malloc(driver_info->show_link_size);
+#endif
 
-        ESP_LOGI(TAG, "%s: initializing display", __func__);
-        ssd1306_i2c_init(display);
+#if CONFIG_SSD1306_I2C_SHADOW_DIFF
+        driver_info->shadow = (uint8_t*) malloc(display->frame_len);
+#endif
 
-        /* Plug override for close */
-        driver_info->close     = display->close;
+        ssd1306_i2c_setup(display, i2c_num, sda_pin, scl_pin, reset_pin, clk_speed);
+    }
 
-        display->_show         = ssd1306_i2c_show;
+    ESP_LOGI(TAG, "%s: returning %p", __func__, display);
+    return display;
+}
+
+display_t *ssd1306_i2c_create_static(ssd1306_i2c_static_t *storage, void *buffer, size_t size,
+                                     int i2c_num, int sda_pin, int scl_pin, int reset_pin, int clk_speed, int width, int height, uint8_t flags)
+{
+    if (size < SSD1306_I2C_STATIC_BUFFER_SIZE(width, height)) {
+        ESP_LOGE(TAG, "%s: buffer needs %d bytes", __func__, (int) SSD1306_I2C_STATIC_BUFFER_SIZE(width, height));
+        return NULL;
+    }
+
+    display_t *display = display_create_static(&storage->display, buffer, DISPLAY_STATIC_BUFFER_SIZE(width, height), width, height, flags);
+
+    if (display != NULL) {
+
+ESP_LOGI(TAG, "%s: i2c_num %d sda_pin %d scl_pin %d reset_pin %d clk_speed %d width %d height %d", __func__, i2c_num, sda_pin, scl_pin, reset_pin, clk_speed, width, height);
+
+        ssd1306_i2c_driver_info *driver_info = &storage->driver_info;
+
+        display->driver_info = (void*) driver_info;
 
-        display->close         = ssd1306_i2c_close;
+        /* Our pieces follow the display's part of the buffer */
+        uint8_t *next = (uint8_t*) DISPLAY_STATIC_ALIGN((uintptr_t) buffer + DISPLAY_STATIC_BUFFER_SIZE(width, height));
 
-        display->contrast      = ssd1306_i2c_contrast;
-        display->enable        = ssd1306_i2c_enable;
+        driver_info->max_windows = SSD1306_MAX_WINDOWS(width, height);
+        driver_info->windows = (ssd1306_window_t*) next;
+        next += DISPLAY_STATIC_ALIGN(driver_info->max_windows * sizeof(ssd1306_window_t));
 
-        /* Clear the display */
-        display->clear(display);
+#if CONFIG_SSD1306_I2C_STATIC_LINKS
+        driver_info->show_link_size = SSD1306_LINK_SIZE(SSD1306_SHOW_LINK_OPS(width, height));
+        driver_info->show_link = next;
+        next += SSD1306_STATIC_LINK_SIZE(width, height);
+#endif
 
-        display->contrast(display, 0x80);
+#if CONFIG_SSD1306_I2C_SHADOW_DIFF
+        driver_info->shadow = next;
+#endif
 
+        ssd1306_i2c_setup(display, i2c_num, sda_pin, scl_pin, reset_pin, clk_speed);
     }
 
     ESP_LOGI(TAG, "%s: returning %p", __func__, display);
@@ -0,0 +1,332 @@
+/*
+ * widget.c
+ *
+ * Retained widgets with incremental invalidation.
+ */
+#include "sdkconfig.h" // generated by "make menuconfig"
+
+#if CONFIG_SSD1306_I2C_ENABLED && CONFIG_DISPLAY_WIDGETS_ENABLED
+
+#include <stdio.h>
+#include <string.h>
+
+#include "widget.h"
+
+/* Inclusive pixel rectangle */
+typedef struct {
+    int x1;
+    int y1;
+    int x2;
+    int y2;
+} widget_rect_t;
+
+void widget_screen_init(widget_screen_t *screen, display_t *display)
+{
+    screen->display = display;
+    screen->first   = NULL;
+    screen->last    = NULL;
+}
+
+static void widget_add(widget_screen_t *screen, widget_t *widget, widget_type_t type, int x, int y, int width, int height)
+{
+    memset(widget, 0, sizeof(*widget));
+
+    widget->type    = type;
+    widget->x       = x;
+    widget->y       = y;
+    widget->width   = width;
+    widget->height  = height;
+    widget->visible = true;
+    widget->invalid = true;
+
+    if (screen->last != NULL) {
+        screen->last->next = widget;
+    } else {
+        screen->first = widget;
+    }
+    screen->last = widget;
+}
+
+void widget_label_init(widget_screen_t *screen, widget_t *widget, int x, int y, int width, display_align_t align, const char *text)
+{
+    widget_add(screen, widget, widget_type_label, x, y, width, screen->display->font_height);
+
+    widget->label.align = align;
+
+    snprintf(widget->label.text, sizeof(widget->label.text), "%s", text);
+    text_trim_utf8(widget->label.text);
+}
+
+void widget_value_init(widget_screen_t *screen, widget_t *widget, int x, int y, int width, display_align_t align, const char *format, int value)
+{
+    widget_add(screen, widget, widget_type_value, x, y, width, screen->display->font_height);
+
+    widget->label.align  = align;
+    widget->label.format = format;
+    widget->label.value  = value;
+
+    snprintf(widget->label.text, sizeof(widget->label.text), format, value);
+    text_trim_utf8(widget->label.text);
+}
+
+void widget_icon_init(widget_screen_t *screen, widget_t *widget, int x, int y, bitmap_t *bitmap)
+{
+    widget_add(screen, widget, widget_type_icon, x, y, bitmap->width, bitmap->height);
+
+    widget->icon.bitmap = bitmap;
+}
+
+void widget_box_init(widget_screen_t *screen, widget_t *widget, int x, int y, int width, int height, draw_flags_t flags)
+{
+    widget_add(screen, widget, widget_type_box, x, y, width, height);
+
+    widget->box.flags = flags;
+}
+
+#if CONFIG_DISPLAY_PROGRESS_BAR_ENABLED
+void widget_progress_bar_init(widget_screen_t *screen, widget_t *widget, int x, int y, int width, int height, int range, int value, bool percent)
+{
+    widget_add(screen, widget, widget_type_progress_bar, x, y, width, height);
+
+    widget->progress_bar.range   = range;
+    widget->progress_bar.value   = value;
+    widget->progress_bar.percent = percent;
+}
+#endif
+
+void widget_set_text(widget_t *widget, const char *text)
+{
+    char copy[sizeof(widget->label.text)];
+
+    /* Compared as stored, cut to the buffer at a character boundary */
+    snprintf(copy, sizeof(copy), "%s", text);
+    text_trim_utf8(copy);
+
+    if (strcmp(widget->label.text, copy) != 0) {
+        memcpy(widget->label.text, copy, sizeof(copy));
+        widget->invalid = true;
+    }
+}
+
+void widget_set_value(widget_t *widget, int value)
+{
+    if (widget->label.value != value) {
+        char text[sizeof(widget->label.text)];
+
+        widget->label.value = value;
+
+        /* Different values can still read the same, e.g. when formatted in units */
+        snprintf(text, sizeof(text), widget->label.format, value);
+        text_trim_utf8(text);
+        widget_set_text(widget, text);
+    }
+}
+
+void widget_set_bitmap(widget_t *widget, bitmap_t *bitmap)
+{
+    if (widget->icon.bitmap != bitmap) {
+        widget->icon.bitmap = bitmap;
+        widget->invalid = true;
+    }
+}
+
+void widget_set_progress(widget_t *widget, int value)
+{
+    if (widget->progress_bar.value != value) {
+        widget->progress_bar.value = value;
+        widget->invalid = true;
+    }
+}
+
+void widget_set_visible(widget_t *widget, bool visible)
+{
+    if (widget->visible != visible) {
+        widget->visible = visible;
+        widget->invalid = true;
+    }
+}
+
+void widget_invalidate(widget_t *widget)
+{
+    widget->invalid = true;
+}
+
+/*
+ * The rectangles a widget paints: its bounds, or only the four edges of a box
+ * that draws just a border, so a frame around other widgets is not repainted
+ * with them.  Returns the count.
+ */
+static int widget_footprint(const widget_t *widget, widget_rect_t rects[4])
+{
+    int x1 = widget->x;
+    int y1 = widget->y;
+    int x2 = widget->x + widget->width - 1;
+    int y2 = widget->y + widget->height - 1;
+
+    if (widget->type == widget_type_box && !(widget->box.flags & (draw_flag_fill | draw_flag_clear))) {
+        rects[0] = (widget_rect_t) { x1, y1, x2, y1 };
+        rects[1] = (widget_rect_t) { x1, y2, x2, y2 };
+        rects[2] = (widget_rect_t) { x1, y1, x1, y2 };
+        rects[3] = (widget_rect_t) { x2, y1, x2, y2 };
+        return 4;
+    }
+
+    rects[0] = (widget_rect_t) { x1, y1, x2, y2 };
+    return 1;
+}
+
+static bool widget_overlaps(const widget_t *a, const widget_t *b)
+{
+    widget_rect_t ra[4], rb[4];
+    int na = widget_footprint(a, ra);
+    int nb = widget_footprint(b, rb);
+
+    for (int i = 0; i < na; ++i) {
+        for (int j = 0; j < nb; ++j) {
+            if (ra[i].x1 <= rb[j].x2 && rb[j].x1 <= ra[i].x2 && ra[i].y1 <= rb[j].y2 && rb[j].y1 <= ra[i].y2) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/* Glyph by glyph, dropping what does not fit the bounds instead of wrapping */
+static void widget_draw_label(display_t *display, widget_t *widget)
+{
+    const font_t *font = display->font;
+    const char *text = widget->label.text;
+    const char *end = text;
+    int width = 0;
+    bitmap_t bitmap;
+
+    while (*end != '\0') {
+        const char *next = end;
+
+        if (char_to_bitmap(&bitmap, font, text_next_char(&next)) != NULL) {
+            if (width + bitmap.width > widget->width) {
+                break;
+            }
+            width += bitmap.width;
+        }
+        end = next;
+    }
+
+    int x = widget->x;
+
+    if (widget->label.align == display_align_center) {
+        x += (widget->width - width) / 2;
+    } else if (widget->label.align == display_align_right) {
+        x += widget->width - width;
+    }
+
+    while (text < end) {
+        if (char_to_bitmap(&bitmap, font, text_next_char(&text)) != NULL) {
+            int height = bitmap.height < widget->height ? bitmap.height : widget->height;
+
+            display->draw_bitmap(display, &bitmap, x, widget->y, bitmap.width, height, bitmap_method_OR);
+            x += bitmap.width;
+        }
+    }
+}
+
+static void widget_draw(display_t *display, widget_t *widget)
+{
+    switch (widget->type) {
+        case widget_type_label:
+        case widget_type_value:
+            widget_draw_label(display, widget);
+            break;
+
+        case widget_type_icon:
+            if (widget->icon.bitmap != NULL) {
+                display->draw_bitmap(display, widget->icon.bitmap, widget->x, widget->y,
+                                     widget->width < widget->icon.bitmap->width ? widget->width : widget->icon.bitmap->width,
+                                     widget->height < widget->icon.bitmap->height ? widget->height : widget->icon.bitmap->height,
+                                     bitmap_method_OR);
+            }
+            break;
+
+#if CONFIG_DISPLAY_PROGRESS_BAR_ENABLED
+        case widget_type_progress_bar: {
+            char text[8];
+
+            snprintf(text, sizeof(text), "%d%%", widget->progress_bar.range > 0 ? widget->progress_bar.value * 100 / widget->progress_bar.range : 0);
+
+            display->draw_progress_bar(display, widget->x, widget->y, widget->width, widget->height,
+                                       widget->progress_bar.range, widget->progress_bar.value,
+                                       widget->progress_bar.percent ? text : NULL);
+            break;
+        }
+#endif
+
+        case widget_type_box:
+            display->draw_rectangle(display, widget->x, widget->y, widget->width, widget->height, widget->box.flags);
+            break;
+    }
+}
+
+/*
+ * Anything sharing pixels with an invalid widget is invalid too, since erasing
+ * the one wipes part of the other.  Then every invalid footprint is erased and
+ * the visible invalid widgets are drawn bottom up, all under one hold.
+ */
+void widget_render(widget_screen_t *screen)
+{
+    display_t *display = screen->display;
+    bool changed = true;
+    bool any = false;
+
+    while (changed) {
+        changed = false;
+
+        for (widget_t *widget = screen->first; widget != NULL; widget = widget->next) {
+            if (widget->invalid) {
+                any = true;
+
+                for (widget_t *other = screen->first; other != NULL; other = other->next) {
+                    if (!other->invalid && other->visible && widget_overlaps(widget, other)) {
+                        other->invalid = true;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    if (!any) {
+        return;
+    }
+
+    display->_lock(display);
+
+    display->hold(display);
+
+    for (widget_t *widget = screen->first; widget != NULL; widget = widget->next) {
+        if (widget->invalid) {
+            widget_rect_t rects[4];
+            int count = widget_footprint(widget, rects);
+
+            for (int index = 0; index < count; ++index) {
+                display->draw_rectangle(display, rects[index].x1, rects[index].y1,
+                                        rects[index].x2 - rects[index].x1 + 1, rects[index].y2 - rects[index].y1 + 1, draw_flag_clear);
+            }
+        }
+    }
+
+    for (widget_t *widget = screen->first; widget != NULL; widget = widget->next) {
+        if (widget->invalid) {
+            if (widget->visible) {
+                widget_draw(display, widget);
+            }
+            widget->invalid = false;
+        }
+    }
+
+    display->show(display);
+
+    display->_unlock(display);
+}
+
+#endif /* CONFIG_SSD1306_I2C_ENABLED && CONFIG_DISPLAY_WIDGETS_ENABLED */